@@ -1,6 +1,7 @@
 #pragma once
 
-#include "basic_model.hpp"
+#include "animation_runtime.hpp"
+#include "debug_draw.hpp"
 #include "shader.hpp"
 
 #include "ozz/animation/runtime/animation.h"
@@ -10,6 +11,9 @@
 #include "ozz/base/maths/soa_transform.h"
 #include "ozz/base/memory/unique_ptr.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <map>
 #include <string>
@@ -32,10 +36,10 @@ static inline glm::mat4 OzzToGlmMat4(const ozz::math::Float4x4& from) {
     return to;
 }
 
-class AnimatedModel : public BasicModel
+class AnimatedModel : public AnimationRuntime
 {
 public:
-    AnimatedModel() : numJoints(0), currentAnimation(0), animationTime(0.0f) {}
+    AnimatedModel() : numJoints(0), currentAnimation(0) {}
     ~AnimatedModel() = default;
 
     void Draw(const Shader& shader) const override
@@ -44,13 +48,42 @@ public:
             mesh.Draw(shader);
     }
 
-    void SetJoints(std::vector<Joint>& j) { joints = j; }
+    void SetJoints(std::vector<Joint>& j)
+    {
+        joints = j;
+        std::vector<int> parents;
+        std::vector<glm::mat4> inverseBindPoses;
+        std::vector<std::string> names;
+        for (const Joint& joint : joints)
+        {
+            parents.push_back(joint.parentIndex);
+            inverseBindPoses.push_back(joint.invBindPose);
+            names.push_back(joint.name);
+        }
+        ikSolver.Init(parents, inverseBindPoses, names);
+    }
 
     void SetSkeleton(RuntimeSkeleton skel)
     {
         skeleton = std::move(skel);
         numJoints = skeleton->num_joints();
-        jointMatrices.resize(numJoints);
+        palette.Resize(numJoints);
+        localTransforms.resize(numJoints);
+        modelSpaceTransforms.resize(numJoints);
+        modelSpaceMatrices.assign(numJoints, glm::mat4(1.0f));
+        previousLocalTransforms.resize(localTransforms.size());
+        jointDirty.assign(numJoints, false);
+        modelSpaceValid = false;
+
+        // Joints are stored depth-first, so each subtree is the contiguous range [joint, subtreeEnd[joint]]
+        const auto parents = skeleton->joint_parents();
+        subtreeEnd.assign(numJoints, 0);
+        for (int i = static_cast<int>(numJoints) - 1; i >= 0; --i)
+        {
+            subtreeEnd[i] = std::max(subtreeEnd[i], i);
+            if (parents[i] != ozz::animation::Skeleton::kNoParent)
+                subtreeEnd[parents[i]] = std::max(subtreeEnd[parents[i]], subtreeEnd[i]);
+        }
     }
 
     void AddAnimation(RuntimeAnimation animation)
@@ -59,15 +92,9 @@ public:
         animations.emplace_back(std::move(animation));
     }
 
-    void SampleAnimation(float deltaTime, const ozz::animation::Animation& animation, ozz::animation::Skeleton& skeleton)
+    bool SampleAnimation(float animationTime, const ozz::animation::Animation& animation, ozz::animation::Skeleton& skeleton)
     {
-        animationTime += deltaTime; // Advance animation time
-        // Wrap around animation time if it exceeds duration
-        if (animationTime > animation.duration())
-            animationTime = fmod(animationTime, animation.duration());
-
         // Step 1: Sample animation
-        std::vector<ozz::math::SoaTransform> localTransforms(numJoints);
         ozz::animation::SamplingJob samplingJob;
         samplingJob.animation = &animation;
         samplingJob.context = &context;
@@ -77,42 +104,100 @@ public:
         if (!samplingJob.Run())
         {
             std::cerr << "Failed to sample animation" << std::endl;
-            return;
+            return false;
         }
 
-        // Step 2: Convert to model space (world transform)
-        std::vector<ozz::math::Float4x4> modelSpaceTransforms(numJoints);
-
-        ozz::animation::LocalToModelJob localToModelJob;
-        localToModelJob.skeleton = &skeleton;
-        localToModelJob.input = ozz::make_span(localTransforms);
-        localToModelJob.output = ozz::make_span(modelSpaceTransforms);
-
-        if (!localToModelJob.Run())
+        // Step 2: Convert to model space (world transform), only the subtrees under changed joints
+        if (!updateModelSpace(skeleton))
         {
             std::cerr << "Failed to convert local to model transforms" << std::endl;
-            std::fill(jointMatrices.begin(), jointMatrices.end(), glm::mat4(1.0f)); // Reset to identity
-            return;
+            palette.Reset(); // Reset to identity
+            modelSpaceValid = false;
+            return false;
         }
 
         // Step 3: Convert to glm::mat4 for GPU
         for (size_t i = 0; i < modelSpaceTransforms.size(); ++i)
-            jointMatrices[i] = OzzToGlmMat4(modelSpaceTransforms[i]) * joints[i].invBindPose;
+        {
+            if (!jointDirty[i])
+                continue;
+            modelSpaceMatrices[i] = OzzToGlmMat4(modelSpaceTransforms[i]);
+            palette[i] = modelSpaceMatrices[i] * joints[i].invBindPose;
+        }
+        return true;
+    }
+
+    const char* GetBackendName() const override { return "ozz"; }
+
+    float GetDuration() const override
+    {
+        return currentAnimation < animations.size() ? animations[currentAnimation]->duration() : 0.0f;
     }
 
-    void UpdateAnimation(float deltaTime)
+    void Sample(float timeInSeconds) override
     {
-        if (animations.empty() || !skeleton) return;
-        if (currentAnimation >= animations.size()) return; // Prevent out-of-bounds access
-        SampleAnimation(deltaTime, *animations[currentAnimation], *skeleton);
+        if (animations.empty() || !skeleton || currentAnimation >= animations.size()) return;
+        const ozz::animation::Animation& animation = *animations[currentAnimation];
+        float animationTime = timeInSeconds > animation.duration() ? fmod(timeInSeconds, animation.duration()) : timeInSeconds;
+        if (!poseCache.IsEnabled())
+        {
+            SampleAnimation(animationTime, animation, *skeleton);
+            return;
+        }
+
+        animationTime = poseCache.Quantize(animationTime, animation.duration());
+        if (const PoseCache::Pose* pose = poseCache.Find(currentAnimation, animationTime))
+        {
+            palette = pose->Palette;
+            modelSpaceMatrices = pose->ModelSpace;
+            modelSpaceValid = false; // The palette no longer matches the last model-space transforms
+        }
+        else if (SampleAnimation(animationTime, animation, *skeleton))
+            poseCache.Store(currentAnimation, animationTime, palette, modelSpaceMatrices);
     }
 
-    void SetBoneTransformations(const Shader& shader)
+    PoseCache* GetPoseCache() override { return &poseCache; }
+    IKSolver* GetIKSolver() override { return ikSolver.IsValid() ? &ikSolver : nullptr; }
+    const std::vector<glm::mat4>* GetModelSpace() const override { return &modelSpaceMatrices; }
+
+    // With partial updates, a sample only recomputes the model-space transforms under joints whose
+    // local transform changed since the previous sample; disabled, every sample updates all joints
+    void SetPartialUpdates(bool enabled)
     {
-        shader.Use();
-        shader.SetBool("animated", HasAnimations());
-        if (HasAnimations())
-            shader.SetMat4v("finalBonesMatrices", jointMatrices);
+        partialUpdates = enabled;
+        modelSpaceValid = false;
+    }
+
+    // Joints whose model-space transform the last sample recomputed
+    unsigned int GetUpdatedJoints() const { return updatedJoints; }
+
+    size_t GetAnimationBytes() const override
+    {
+        size_t bytes = 0;
+        for (const auto& animation : animations)
+            bytes += animation->size();
+        return bytes;
+    }
+
+    // Submits the bones of the last sampled pose as overlay lines, each joint to its parent
+    void DrawSkeleton(const glm::mat4& modelMatrix, int selectedJoint = -1) const override
+    {
+        if (!skeleton)
+            return;
+        const glm::vec3 boneColor(0.0f, 1.0f, 1.0f), selectedColor(1.0f, 1.0f, 0.0f);
+        const auto parents = skeleton->joint_parents();
+        DebugDraw& debugDraw = DebugDraw::GetInstance();
+        debugDraw.SetOverlay(true);
+        for (unsigned int i = 0; i < numJoints; ++i)
+        {
+            glm::vec3 position(modelMatrix * modelSpaceMatrices[i][3]);
+            bool selected = static_cast<int>(i) == selectedJoint;
+            if (parents[i] != ozz::animation::Skeleton::kNoParent)
+                debugDraw.Line(glm::vec3(modelMatrix * modelSpaceMatrices[parents[i]][3]), position, selected ? selectedColor : boneColor);
+            if (selected)
+                debugDraw.Sphere(position, 0.03f, selectedColor, 8);
+        }
+        debugDraw.SetOverlay(false);
     }
 
     void SetCurrentAnimation(const std::string& animName)
@@ -125,7 +210,7 @@ public:
         }
     }
 
-    void SetCurrentAnimation(const unsigned int index)
+    void SetCurrentAnimation(unsigned int index) override
     {
         if (index < animations.size())
         {
@@ -134,8 +219,10 @@ public:
         }
     }
 
-    const bool HasAnimations() { return !animations.empty(); }
-    const unsigned int GetNumAnimations() { return animations.size(); }
+    unsigned int GetNumAnimations() const override { return static_cast<unsigned int>(animations.size()); }
+    unsigned int GetCurrentAnimation() const override { return currentAnimation; }
+    unsigned int GetNumJoints() const override { return numJoints; }
+    const std::string& GetJointName(unsigned int index) const override { return joints[index].name; }
     std::map<std::string, unsigned int>& GetAnimationList() { return animationsMap; }
 
     void Debug()
@@ -164,6 +251,78 @@ private:
     std::map<std::string, unsigned int> animationsMap;
     ozz::animation::SamplingJob::Context context;
     unsigned int currentAnimation;
-    float animationTime;
-    std::vector<glm::mat4> jointMatrices;
+    std::vector<ozz::math::SoaTransform> localTransforms; // Sampling scratch, kept to avoid per-frame allocations
+    std::vector<ozz::math::Float4x4> modelSpaceTransforms;
+    std::vector<glm::mat4> modelSpaceMatrices; // Joint transforms of the last sample, without the inverse bind pose
+    PoseCache poseCache;
+    IKSolver ikSolver;
+
+    // Partial LocalToModel state: the locals the model-space transforms were computed from, the joints
+    // the last sample recomputed and the last joint of each subtree
+    std::vector<ozz::math::SoaTransform> previousLocalTransforms;
+    std::vector<bool> jointDirty;
+    std::vector<int> subtreeEnd;
+    bool partialUpdates = true;
+    bool modelSpaceValid = false;
+    unsigned int updatedJoints = 0;
+
+    // Bit mask of the lanes of one SoA block whose local transform differs from the previous sample.
+    // Compared bitwise, so an unchanged joint is guaranteed to convert to the same matrix.
+    unsigned int changedLanes(size_t block) const
+    {
+        static_assert(sizeof(ozz::math::SoaTransform) == 10 * 4 * sizeof(uint32_t), "SoaTransform is 10 components of 4 lanes");
+        uint32_t current[10][4], previous[10][4];
+        memcpy(current, &localTransforms[block], sizeof(current));
+        memcpy(previous, &previousLocalTransforms[block], sizeof(previous));
+        unsigned int mask = 0;
+        for (int component = 0; component < 10; ++component)
+            for (int lane = 0; lane < 4; ++lane)
+                if (current[component][lane] != previous[component][lane])
+                    mask |= 1u << lane;
+        return mask;
+    }
+
+    bool updateModelSpace(ozz::animation::Skeleton& skeleton)
+    {
+        ozz::animation::LocalToModelJob localToModelJob;
+        localToModelJob.skeleton = &skeleton;
+        localToModelJob.input = ozz::make_span(localTransforms);
+        localToModelJob.output = ozz::make_span(modelSpaceTransforms);
+
+        updatedJoints = 0;
+        if (!partialUpdates || !modelSpaceValid)
+        {
+            if (!localToModelJob.Run())
+                return false;
+            std::fill(jointDirty.begin(), jointDirty.end(), true);
+            updatedJoints = numJoints;
+        }
+        else
+        {
+            // Parents come before children, so one pass marks every joint under a changed one; a changed
+            // joint without a dirty parent roots a subtree that is updated on its own
+            const auto parents = skeleton.joint_parents();
+            unsigned int changed = 0;
+            for (unsigned int i = 0; i < numJoints; ++i)
+            {
+                if (i % 4 == 0)
+                    changed = changedLanes(i / 4);
+                const int parent = parents[i];
+                const bool parentDirty = parent != ozz::animation::Skeleton::kNoParent && jointDirty[parent];
+                jointDirty[i] = parentDirty || (changed & (1u << (i % 4)));
+                if (!jointDirty[i] || parentDirty)
+                    continue;
+
+                localToModelJob.from = static_cast<int>(i);
+                localToModelJob.to = subtreeEnd[i];
+                if (!localToModelJob.Run())
+                    return false;
+                updatedJoints += subtreeEnd[i] - i + 1;
+            }
+        }
+
+        previousLocalTransforms = localTransforms;
+        modelSpaceValid = true;
+        return true;
+    }
 };
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "animation_runtime.hpp"
+#include "model_loader.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Runs the same clips of one asset through every animation backend and reports, per clip, the sampling
+// cost per joint, the resident key data and how far each backend's pose is from the first one's.
+class AnimationBenchmark
+{
+public:
+    static void Run(const std::string& path, unsigned int frames = 2000)
+    {
+        const AnimationBackend backends[] = { AnimationBackend::Ozz, AnimationBackend::Assimp };
+        std::vector<std::unique_ptr<AnimationRuntime>> runtimes;
+        for (AnimationBackend backend : backends)
+        {
+            auto runtime = ModelLoader::GetInstance().LoadAnimated(path, backend);
+            if (!runtime || !runtime->HasAnimations())
+            {
+                std::cerr << "ERROR::ANIMATIONBENCHMARK: No animations to benchmark in \"" << path << "\"" << std::endl;
+                return;
+            }
+            runtimes.push_back(std::move(runtime));
+        }
+
+        // Joints are matched by name, the backends order them differently
+        const AnimationRuntime& reference = *runtimes[0];
+        std::map<std::string, unsigned int> referenceJoints;
+        for (unsigned int i = 0; i < reference.GetNumJoints(); ++i)
+            referenceJoints[reference.GetJointName(i)] = i;
+
+        unsigned int numAnimations = reference.GetNumAnimations();
+        for (const auto& runtime : runtimes)
+            numAnimations = std::min(numAnimations, runtime->GetNumAnimations());
+
+        std::cout << "Animation benchmark \"" << path << "\": " << frames << " samples at 60 Hz per clip" << std::endl;
+        for (const auto& runtime : runtimes)
+            std::cout << "  " << runtime->GetBackendName() << ": " << runtime->GetNumJoints() << " joints, "
+                      << runtime->GetAnimationBytes() / 1024.0 << " KB of animation data" << std::endl;
+
+        const float deltaTime = 1.0f / 60.0f;
+        for (unsigned int animation = 0; animation < numAnimations; ++animation)
+        {
+            std::cout << "  Clip " << animation << ":";
+            for (const auto& runtime : runtimes)
+            {
+                runtime->SetCurrentAnimation(animation);
+                auto start = std::chrono::steady_clock::now();
+                for (unsigned int i = 0; i < frames; ++i)
+                    runtime->Sample(i * deltaTime);
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                std::cout << " " << runtime->GetBackendName() << " " << seconds * 1e9 / (static_cast<double>(frames) * runtime->GetNumJoints())
+                          << " ns/joint";
+            }
+
+            for (size_t r = 1; r < runtimes.size(); ++r)
+                std::cout << ", " << runtimes[r]->GetBackendName() << " max error "
+                          << poseError(reference, *runtimes[r], referenceJoints, frames, deltaTime);
+            std::cout << std::endl;
+        }
+    }
+
+private:
+    // Largest component difference between matching skinning matrices, over a spread of sample times
+    static float poseError(AnimationRuntime& reference, AnimationRuntime& runtime,
+        const std::map<std::string, unsigned int>& referenceJoints, unsigned int frames, float deltaTime)
+    {
+        float error = 0.0f;
+        for (unsigned int i = 0; i < frames; i += std::max(frames / 16, 1u))
+        {
+            reference.Sample(i * deltaTime);
+            runtime.Sample(i * deltaTime);
+            for (unsigned int joint = 0; joint < runtime.GetNumJoints(); ++joint)
+            {
+                auto match = referenceJoints.find(runtime.GetJointName(joint));
+                if (match == referenceJoints.end())
+                    continue;
+                const glm::mat4& a = reference.GetPalette()[match->second];
+                const glm::mat4& b = runtime.GetPalette()[joint];
+                for (int column = 0; column < 4; ++column)
+                {
+                    glm::vec4 difference = glm::abs(a[column] - b[column]);
+                    error = std::max(error, std::max(std::max(difference.x, difference.y), std::max(difference.z, difference.w)));
+                }
+            }
+        }
+        return error;
+    }
+};
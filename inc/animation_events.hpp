@@ -0,0 +1,186 @@
+#pragma once
+
+#include "playback_clock.hpp"
+
+#include <assimp/scene.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// A named point in a clip: an event such as a footstep or a hit frame, or a sync marker
+struct AnimationEvent
+{
+    float Time; // Seconds into the clip
+    std::string Name;
+};
+
+// Events and sync markers of one clip, each sorted by time. Sync markers split a looping clip into
+// segments, e.g. left foot down to right foot down, so two locomotion clips can be lined up by segment
+// instead of by normalized time.
+struct ClipEvents
+{
+    std::vector<AnimationEvent> Events;
+    std::vector<AnimationEvent> SyncMarkers;
+
+    // Reads "events.<clip>" and "sync.<clip>" string metadata from the scene or its root node, which is
+    // where Assimp puts glTF extras and FBX user properties. Values are "name@seconds" entries separated
+    // by spaces or commas. Returns one entry per scene animation, in scene order.
+    static std::vector<ClipEvents> FromScene(const aiScene* scene)
+    {
+        std::vector<ClipEvents> clips(scene->mNumAnimations);
+        for (unsigned int a = 0; a < scene->mNumAnimations; ++a)
+        {
+            const std::string clipName = scene->mAnimations[a]->mName.C_Str();
+            for (const aiMetadata* metadata : { scene->mMetaData, scene->mRootNode ? scene->mRootNode->mMetaData : nullptr })
+            {
+                if (!metadata)
+                    continue;
+                aiString value;
+                if (metadata->Get("events." + clipName, value))
+                    parse(value.C_Str(), clipName, clips[a].Events);
+                if (metadata->Get("sync." + clipName, value))
+                    parse(value.C_Str(), clipName, clips[a].SyncMarkers);
+            }
+        }
+        return clips;
+    }
+
+    // Segment between two sync markers a clip time falls in, and how far through it; the last segment
+    // wraps to the first marker. -1 without markers.
+    int FindSyncSegment(float time, float duration, float& fraction) const
+    {
+        if (SyncMarkers.empty() || duration <= 0.0f)
+            return -1;
+        auto after = std::upper_bound(SyncMarkers.begin(), SyncMarkers.end(), time,
+            [](float t, const AnimationEvent& marker) { return t < marker.Time; });
+        int segment = after == SyncMarkers.begin() ? static_cast<int>(SyncMarkers.size()) - 1 : static_cast<int>(after - SyncMarkers.begin()) - 1;
+        float start = SyncMarkers[segment].Time, length = segmentLength(segment, duration);
+        if (time < start)
+            start -= duration;
+        fraction = length > 0.0f ? (time - start) / length : 0.0f;
+        return segment;
+    }
+
+    // Clip time the same fraction through a segment
+    float GetSyncTime(int segment, float fraction, float duration) const
+    {
+        if (SyncMarkers.empty() || duration <= 0.0f)
+            return 0.0f;
+        segment %= static_cast<int>(SyncMarkers.size());
+        float time = SyncMarkers[segment].Time + fraction * segmentLength(segment, duration);
+        return time >= duration ? time - duration : time;
+    }
+
+    // Index of the first sync marker with this name, -1 if there is none
+    int FindSyncMarker(const std::string& name) const
+    {
+        for (size_t i = 0; i < SyncMarkers.size(); ++i)
+            if (SyncMarkers[i].Name == name)
+                return static_cast<int>(i);
+        return -1;
+    }
+
+private:
+    float segmentLength(int segment, float duration) const
+    {
+        float end = segment + 1 < static_cast<int>(SyncMarkers.size()) ? SyncMarkers[segment + 1].Time : SyncMarkers[0].Time + duration;
+        return end - SyncMarkers[segment].Time;
+    }
+
+    static void parse(const std::string& value, const std::string& clipName, std::vector<AnimationEvent>& events)
+    {
+        std::string entries = value;
+        std::replace(entries.begin(), entries.end(), ',', ' ');
+        std::istringstream stream(entries);
+        std::string entry;
+        while (stream >> entry)
+        {
+            size_t at = entry.find('@');
+            try
+            {
+                if (at == std::string::npos || at == 0)
+                    throw std::invalid_argument(entry);
+                events.push_back({ std::stof(entry.substr(at + 1)), entry.substr(0, at) });
+            }
+            catch (const std::exception&)
+            {
+                std::cerr << "ERROR::ANIMATIONEVENTS: Malformed entry \"" << entry << "\" for clip \"" << clipName << "\"" << std::endl;
+            }
+        }
+        std::stable_sort(events.begin(), events.end(), [](const AnimationEvent& a, const AnimationEvent& b) { return a.Time < b.Time; });
+    }
+};
+
+// Position of one playback in a clip's event list. Each advance emits only the events between the
+// previous and the new clip time, walking from the remembered index, so a frame costs nothing when no
+// event is crossed and never allocates. Seeks and clip changes re-seat the cursor without emitting.
+class AnimationEventCursor
+{
+public:
+    // clipTime is the playback position before this step, delta the change of the clock's elapsed time,
+    // which carries the direction and any laps
+    template<typename Emit>
+    void Advance(const ClipEvents& clip, double clipTime, double delta, double duration, PlaybackMode mode, Emit&& emit)
+    {
+        const std::vector<AnimationEvent>& events = clip.Events;
+        if (&clip != current || std::abs(clipTime - time) > 1e-4)
+            seat(clip, clipTime);
+        if (events.empty() || duration <= 0.0)
+        {
+            time = clipTime;
+            return;
+        }
+
+        // Whole laps beyond the first emit nothing new, e.g. after a long hitch
+        if (std::abs(delta) > duration)
+            delta = std::copysign(duration + std::fmod(std::abs(delta), duration), delta);
+        double target = time + delta;
+        if (mode == PlaybackMode::Clamp)
+            target = std::clamp(target, 0.0, duration);
+
+        // next is the first event after the current time
+        if (delta >= 0.0)
+        {
+            while (true)
+            {
+                while (next < events.size() && events[next].Time <= target)
+                    emit(events[next++]);
+                if (target < duration || mode == PlaybackMode::Clamp)
+                    break;
+                target -= duration;
+                next = 0;
+            }
+        }
+        else
+        {
+            while (true)
+            {
+                while (next > 0 && events[next - 1].Time > target)
+                    emit(events[--next]);
+                if (target >= 0.0 || mode == PlaybackMode::Clamp)
+                    break;
+                target += duration;
+                next = events.size();
+            }
+        }
+        time = target;
+    }
+
+private:
+    const ClipEvents* current = nullptr;
+    size_t next = 0;
+    double time = 0.0;
+
+    void seat(const ClipEvents& clip, double clipTime)
+    {
+        current = &clip;
+        time = clipTime;
+        next = std::upper_bound(clip.Events.begin(), clip.Events.end(), clipTime,
+            [](double t, const AnimationEvent& event) { return t < event.Time; }) - clip.Events.begin();
+    }
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "animation_events.hpp"
+#include "basic_model.hpp"
+#include "bone_palette.hpp"
+#include "ik_solver.hpp"
+#include "playback_clock.hpp"
+#include "pose_cache.hpp"
+#include "shader.hpp"
+
+#include <glm/glm.hpp>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Which runtime samples an asset's clips, see ModelLoader::LoadAnimated
+enum class AnimationBackend
+{
+    Ozz,   // AnimatedModel: clips compressed into ozz runtime animations
+    Assimp // SkinnedModel: Assimp key tracks baked at load
+};
+
+// Animated model whose clips are sampled into a bone palette. The backends differ in how they store
+// and sample keys, so the renderer only talks to this interface and the backend is picked per asset.
+class AnimationRuntime : public BasicModel
+{
+public:
+    virtual ~AnimationRuntime() = default;
+
+    virtual const char* GetBackendName() const = 0;
+
+    virtual unsigned int GetNumAnimations() const = 0;
+    virtual void SetCurrentAnimation(unsigned int index) = 0;
+    virtual unsigned int GetCurrentAnimation() const = 0;
+    virtual float GetDuration() const = 0; // Of the current clip, in seconds
+
+    // Samples the current clip at a time in seconds; times past the end wrap, the end itself is the last pose
+    virtual void Sample(float timeInSeconds) = 0;
+
+    // Joints are indexed like the palette and the vertices' bone IDs
+    virtual unsigned int GetNumJoints() const = 0;
+    virtual const std::string& GetJointName(unsigned int index) const = 0;
+
+    // Bytes of key data kept resident for sampling
+    virtual size_t GetAnimationBytes() const = 0;
+
+    // Poses shared between instances, null for backends without one
+    virtual PoseCache* GetPoseCache() { return nullptr; }
+
+    // Foot placement and look-at for this model's skeleton, null for backends without one
+    virtual IKSolver* GetIKSolver() { return nullptr; }
+
+    // Joint transforms of the last sample without the inverse bind pose, null for backends that do not keep them
+    virtual const std::vector<glm::mat4>* GetModelSpace() const { return nullptr; }
+
+    // Submits the bones of the last sampled pose to DebugDraw, backends without one draw nothing
+    virtual void DrawSkeleton(const glm::mat4& /*modelMatrix*/, int /*selectedJoint*/ = -1) const {}
+
+    // Advances this instance's clock, emits the events it crossed to the event handler and samples the
+    // current clip where it now points
+    void UpdateAnimation(double deltaTime)
+    {
+        const double duration = GetDuration();
+        const double clipTime = clock.GetClipTime(duration), elapsed = clock.GetElapsed();
+        clock.Advance(deltaTime);
+        if (eventHandler)
+            eventCursor.Advance(GetClipEvents(GetCurrentAnimation()), clipTime, clock.GetElapsed() - elapsed, duration, clock.Mode, eventHandler);
+        Sample(static_cast<float>(clock.GetClipTime(duration)));
+    }
+
+    // Switches clips keeping the position between sync markers, e.g. walk to run on the same foot; the
+    // segment is matched by its starting marker's name. Without markers on both clips it is a plain switch.
+    void SetCurrentAnimationSynced(unsigned int index)
+    {
+        const ClipEvents& from = GetClipEvents(GetCurrentAnimation());
+        float fraction = 0.0f;
+        const int segment = from.FindSyncSegment(static_cast<float>(clock.GetClipTime(GetDuration())), GetDuration(), fraction);
+        SetCurrentAnimation(index);
+        const ClipEvents& to = GetClipEvents(GetCurrentAnimation());
+        if (segment < 0 || to.SyncMarkers.empty())
+            return;
+        int target = to.FindSyncMarker(from.SyncMarkers[segment].Name);
+        const double duration = GetDuration();
+        clock.SetElapsed(to.GetSyncTime(target >= 0 ? target : segment, fraction, static_cast<float>(duration)) - clock.Phase * duration);
+    }
+
+    // Events and sync markers, one entry per clip; clips without any get an empty entry
+    void SetClipEvents(std::vector<ClipEvents> events) { clipEvents = std::move(events); }
+    const ClipEvents& GetClipEvents(unsigned int clip) const
+    {
+        static const ClipEvents none;
+        return clip < clipEvents.size() ? clipEvents[clip] : none;
+    }
+
+    // Called from UpdateAnimation for every event its step crossed, in playback order
+    void SetEventHandler(std::function<void(const AnimationEvent&)> handler) { eventHandler = std::move(handler); }
+
+    PlaybackClock& GetClock() { return clock; }
+
+    bool HasAnimations() const { return GetNumAnimations() > 0; }
+    const BonePalette& GetPalette() const { return palette; }
+
+    void SetBoneTransformations(const Shader& shader) const { palette.Upload(shader, HasAnimations()); }
+
+protected:
+    BonePalette palette;
+    PlaybackClock clock;
+    std::vector<ClipEvents> clipEvents;
+    AnimationEventCursor eventCursor;
+    std::function<void(const AnimationEvent&)> eventHandler;
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "animation_runtime.hpp"
+#include "gl_state.hpp"
+#include "gpu_memory.hpp"
+#include "shader.hpp"
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_access.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Every clip of a model sampled at about a fixed rate into one RGBA32F texture, for crowds animated entirely
+// on the GPU (see crowd.vs). Each row is one frame; each joint takes three texels, the rows of its
+// 3x4 skinning matrix. Clips are stacked vertically and described by a small uniform table.
+class AnimationTexture
+{
+public:
+    static constexpr int MAX_CLIPS = 16; // Matches crowd.vs
+
+    struct Clip
+    {
+        int firstRow;
+        int numFrames;
+        float duration;
+    };
+
+    // Samples through the model's current backend, so the bake matches what CPU playback shows
+    bool Bake(AnimationRuntime& model, float framesPerSecond = 30.0f)
+    {
+        const unsigned int numJoints = model.GetNumJoints();
+        const unsigned int numClips = std::min<unsigned int>(model.GetNumAnimations(), MAX_CLIPS);
+        if (numJoints == 0 || numClips == 0)
+        {
+            std::cerr << "ERROR::ANIMATIONTEXTURE: Nothing to bake" << std::endl;
+            return false;
+        }
+
+        width = static_cast<GLsizei>(numJoints * 3);
+        clips.clear();
+        std::vector<glm::vec4> texels;
+        for (unsigned int c = 0; c < numClips; ++c)
+        {
+            model.SetCurrentAnimation(c);
+            Clip clip{ static_cast<int>(texels.size() / width), 0, model.GetDuration() };
+            // Evenly over [0, duration], first and last frame included, so no interval is shorter
+            clip.numFrames = static_cast<int>(std::ceil(clip.duration * framesPerSecond)) + 1;
+            for (int frame = 0; frame < clip.numFrames; ++frame)
+            {
+                model.Sample(clip.numFrames > 1 ? frame * clip.duration / (clip.numFrames - 1) : 0.0f);
+                const BonePalette& palette = model.GetPalette();
+                for (unsigned int joint = 0; joint < numJoints; ++joint)
+                    for (int row = 0; row < 3; ++row)
+                        texels.push_back(glm::row(palette[joint], row));
+            }
+            clips.push_back(clip);
+        }
+        height = static_cast<GLsizei>(texels.size() / width);
+
+        if (ID == 0)
+            glGenTextures(1, &ID);
+        GLState::GetInstance().BindTexture(GL_TEXTURE_2D, ID);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, texels.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        GpuMemory::GetInstance().TrackTexture(ID, texels.size() * sizeof(glm::vec4), GpuMemoryCategory::Texture, "animation texture");
+        return true;
+    }
+
+    // Binds the texture to unit and sets the clip table on the shader
+    void Bind(const Shader& shader, GLuint unit) const
+    {
+        shader.Use();
+        shader.SetInt("animationTexture", static_cast<int>(unit));
+        for (size_t i = 0; i < clips.size(); ++i)
+            shader.SetVec3("animationClips[" + std::to_string(i) + "]",
+                glm::vec3(clips[i].firstRow, clips[i].numFrames, clips[i].duration));
+        GLState& glState = GLState::GetInstance();
+        glState.BindTexture(unit, GL_TEXTURE_2D, ID);
+        glState.BindSampler(unit, 0);
+    }
+
+    unsigned int GetNumClips() const { return static_cast<unsigned int>(clips.size()); }
+    float GetDuration(unsigned int clip) const { return clips[clip].duration; }
+
+private:
+    GLuint ID = 0;
+    GLsizei width = 0, height = 0;
+    std::vector<Clip> clips;
+};
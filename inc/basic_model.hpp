@@ -3,6 +3,7 @@
 #include "mesh.hpp"
 #include "shader.hpp"
 
+#include <algorithm>
 #include <vector>
 
 class BasicModel
@@ -10,11 +11,22 @@ class BasicModel
 public:
     virtual void Draw(const Shader& shader) const = 0;
 
+    // Meshes are kept ordered by material so consecutive draws share bindings
     void AddMesh(const Mesh& mesh)
     {
-        meshes.emplace_back(mesh);
+        auto it = std::upper_bound(meshes.begin(), meshes.end(), mesh.GetMaterial().GetSortKey(),
+            [](uint64_t key, const Mesh& other) { return key < other.GetMaterial().GetSortKey(); });
+        meshes.insert(it, mesh);
     }
 
+    void DrawInstanced(const Shader& shader, GLsizei instances) const
+    {
+        for (const auto& mesh : meshes)
+            mesh.DrawInstanced(shader, instances);
+    }
+
+    const std::vector<Mesh>& GetMeshes() const { return meshes; }
+
     void Debug() const
     {
         std::cout << "Meshes:" << std::endl;
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "shader.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <vector>
+
+// Skinning matrices laid out like the shader's finalBonesMatrices array. Both animation paths compute
+// straight into a persistent palette and upload it with one glUniformMatrix4fv, so a frame builds no
+// temporary vectors.
+class BonePalette
+{
+public:
+    void Resize(size_t numBones) { matrices.assign(numBones, glm::mat4(1.0f)); }
+    void Reset() { std::fill(matrices.begin(), matrices.end(), glm::mat4(1.0f)); }
+
+    glm::mat4& operator[](size_t bone) { return matrices[bone]; }
+    const glm::mat4& operator[](size_t bone) const { return matrices[bone]; }
+    size_t GetSize() const { return matrices.size(); }
+    const std::vector<glm::mat4>& GetMatrices() const { return matrices; }
+
+    // Without animation, or with an empty palette, the mesh is drawn in its bind pose
+    void Upload(const Shader& shader, bool animated = true) const
+    {
+        animated = animated && !matrices.empty();
+        shader.Use();
+        shader.SetBool("animated", animated);
+        if (animated)
+            shader.SetMat4v("finalBonesMatrices", matrices);
+    }
+
+private:
+    std::vector<glm::mat4> matrices;
+};
@@ -1,11 +1,12 @@
 #pragma once
 
 #include "basic_model.hpp"
+#include "texture_array.hpp"
 
 #include <string>
 #include <vector>
 
-class CubeModel : BasicModel
+class CubeModel : public BasicModel
 {
 public:
     CubeModel(const std::string& texturePath)
@@ -74,10 +75,10 @@ private:
 
         // Texture setup
         std::vector<Texture> textures = {
-            { Texture2D(texturePath), "texture_diffuse", texturePath }
+            { TextureArrayPool::GetInstance().Load(texturePath), TextureSlot::Diffuse, texturePath }
         };
 
         // Create the mesh
-        AddMesh({ vertices, indices, textures });
+        AddMesh({ vertices, indices, std::make_shared<Material>(textures), "cube" });
     }
 };
\ No newline at end of file
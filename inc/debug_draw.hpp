@@ -0,0 +1,184 @@
+#pragma once
+
+#include "gl_state.hpp"
+#include "gpu_memory.hpp"
+#include "shader.hpp"
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Immediate-mode debug lines. Shapes are accumulated into one vertex array during the frame and
+// Flush uploads it into a single streaming buffer and draws everything with one glDrawArrays.
+// Overlay shapes, e.g. a skeleton inside its mesh, go into a second range drawn without depth test.
+class DebugDraw
+{
+public:
+    static DebugDraw& GetInstance()
+    {
+        static DebugDraw instance;
+        return instance;
+    }
+
+    // Routes the following shapes to the overlay range until switched back
+    void SetOverlay(bool overlay) { batch = overlay ? OVERLAY : WORLD; }
+
+    void Line(const glm::vec3& from, const glm::vec3& to, const glm::vec3& color)
+    {
+        uint32_t packed = pack(color);
+        current().push_back({ from, packed });
+        current().push_back({ to, packed });
+    }
+
+    // Corners ordered as GetFrustumCornersWorldSpace: near then far, bottom left, bottom right, top left, top right
+    void Box(const glm::vec3 corners[8], const glm::vec3& color)
+    {
+        static constexpr int edges[24] = {
+            0, 1, 1, 3, 3, 2, 2, 0, // Near plane
+            4, 5, 5, 7, 7, 6, 6, 4, // Far plane
+            0, 4, 1, 5, 2, 6, 3, 7  // Connect near and far planes
+        };
+        uint32_t packed = pack(color);
+        for (int index : edges)
+            current().push_back({ corners[index], packed });
+    }
+
+    void AABB(const glm::vec3& min, const glm::vec3& max, const glm::vec3& color)
+    {
+        glm::vec3 corners[8];
+        for (int i = 0; i < 8; ++i)
+            corners[i] = glm::vec3(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z);
+        Box(corners, color);
+    }
+
+    // The volume a view-projection matrix sees, e.g. a camera or a shadow cascade
+    void Frustum(const glm::mat4& viewProjMatrix, const glm::vec3& color)
+    {
+        const glm::mat4 inv = glm::inverse(viewProjMatrix);
+        glm::vec3 corners[8];
+        for (int i = 0; i < 8; ++i)
+        {
+            glm::vec4 corner = inv * glm::vec4(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, i & 4 ? 1.0f : -1.0f, 1.0f);
+            corners[i] = glm::vec3(corner / corner.w);
+        }
+        Box(corners, color);
+    }
+
+    // Three axis-aligned circles
+    void Sphere(const glm::vec3& center, float radius, const glm::vec3& color, int segments = 16)
+    {
+        uint32_t packed = pack(color);
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            glm::vec3 previous(0.0f);
+            for (int i = 0; i <= segments; ++i)
+            {
+                float angle = glm::two_pi<float>() * i / segments;
+                glm::vec3 offset(0.0f);
+                offset[(axis + 1) % 3] = radius * glm::cos(angle);
+                offset[(axis + 2) % 3] = radius * glm::sin(angle);
+                glm::vec3 point = center + offset;
+                if (i > 0)
+                {
+                    current().push_back({ previous, packed });
+                    current().push_back({ point, packed });
+                }
+                previous = point;
+            }
+        }
+    }
+
+    // Red, green and blue lines along the X, Y and Z axes of a transform
+    void Axes(const glm::mat4& transform, float size)
+    {
+        glm::vec3 origin(transform[3]);
+        Line(origin, origin + glm::vec3(transform[0]) * size, glm::vec3(1.0f, 0.0f, 0.0f));
+        Line(origin, origin + glm::vec3(transform[1]) * size, glm::vec3(0.0f, 1.0f, 0.0f));
+        Line(origin, origin + glm::vec3(transform[2]) * size, glm::vec3(0.0f, 0.0f, 1.0f));
+    }
+
+    // Draws everything submitted since the last flush, one call per non-empty range; the shader's
+    // view/projection must be set
+    void Flush(const Shader& shader)
+    {
+        const size_t numWorld = batches[WORLD].size(), numOverlay = batches[OVERLAY].size();
+        numVertices = numWorld + numOverlay;
+        if (numVertices == 0)
+            return;
+        if (VAO == 0)
+            setupBuffers();
+
+        GLState& glState = GLState::GetInstance();
+        shader.Use();
+        glState.BindVertexArray(VAO);
+        glState.BindBuffer(GL_ARRAY_BUFFER, VBO);
+        while (capacity < numVertices)
+            capacity *= 2;
+        // Orphan the previous frame's storage so the upload does not wait for its draw
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(Vertex), nullptr, GL_STREAM_DRAW);
+        GpuMemory::GetInstance().TrackBuffer(VBO, capacity * sizeof(Vertex), GpuMemoryCategory::Vertex, "debug lines");
+        if (numWorld > 0)
+        {
+            glState.BufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(numWorld * sizeof(Vertex)), batches[WORLD].data());
+            glState.DrawArrays(GL_LINES, 0, static_cast<GLsizei>(numWorld));
+        }
+        if (numOverlay > 0)
+        {
+            glState.BufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(numWorld * sizeof(Vertex)),
+                static_cast<GLsizeiptr>(numOverlay * sizeof(Vertex)), batches[OVERLAY].data());
+            glState.SetEnabled(GL_DEPTH_TEST, false);
+            glState.DrawArrays(GL_LINES, static_cast<GLint>(numWorld), static_cast<GLsizei>(numOverlay));
+            glState.SetEnabled(GL_DEPTH_TEST, true);
+        }
+
+        batches[WORLD].clear();
+        batches[OVERLAY].clear();
+    }
+
+    // Vertices drawn by the last flush
+    size_t GetNumVertices() const { return numVertices; }
+
+private:
+    struct Vertex
+    {
+        glm::vec3 position;
+        uint32_t color; // RGBA8, normalized in the shader
+    };
+
+    static constexpr int WORLD = 0, OVERLAY = 1;
+
+    std::vector<Vertex> batches[2];
+    int batch = WORLD;
+    size_t capacity = 4096;
+    size_t numVertices = 0;
+    GLuint VAO = 0, VBO = 0;
+
+    DebugDraw() {}
+    DebugDraw(const DebugDraw&) = delete;
+    DebugDraw& operator=(const DebugDraw&) = delete;
+
+    std::vector<Vertex>& current() { return batches[batch]; }
+
+    static uint32_t pack(const glm::vec3& color) { return glm::packUnorm4x8(glm::vec4(color, 1.0f)); }
+
+    void setupBuffers()
+    {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+
+        GLState& glState = GLState::GetInstance();
+        glState.BindVertexArray(VAO);
+        glState.BindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(Vertex), nullptr, GL_STREAM_DRAW);
+
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (void*)offsetof(Vertex, color));
+    }
+};
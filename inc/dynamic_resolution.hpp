@@ -0,0 +1,167 @@
+#pragma once
+
+#include "gl_state.hpp"
+#include "gpu_memory.hpp"
+#include "gpu_timer.hpp"
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+// Renders the scene into an offscreen target whose resolution follows the measured GPU time, then
+// upscales it into the default framebuffer. The target is allocated once at the largest scale and
+// smaller frames use its lower-left corner, so changing the scale never reallocates.
+class DynamicResolution
+{
+public:
+    struct Config
+    {
+        float MinScale = 0.5f; // Of the window's width and height
+        float MaxScale = 1.0f;
+        float BudgetMilliseconds = 14.0f; // GPU time per frame the scale aims for
+    };
+
+    ~DynamicResolution()
+    {
+        release();
+    }
+
+    DynamicResolution() = default;
+    DynamicResolution(const DynamicResolution&) = delete;
+    DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+    bool Create(GLsizei width, GLsizei height, const Config& newConfig)
+    {
+        release();
+        config = newConfig;
+        config.MinScale = std::clamp(config.MinScale, 0.1f, 1.0f);
+        config.MaxScale = std::clamp(config.MaxScale, config.MinScale, 1.0f); // The G-buffer is window-sized
+        windowWidth = width;
+        windowHeight = height;
+        scale = config.MaxScale;
+        targetWidth = static_cast<GLsizei>(std::ceil(width * config.MaxScale));
+        targetHeight = static_cast<GLsizei>(std::ceil(height * config.MaxScale));
+
+        GLState& glState = GLState::GetInstance();
+        GpuMemory& gpuMemory = GpuMemory::GetInstance();
+        glGenFramebuffers(1, &framebuffer);
+        glState.BindFramebuffer(framebuffer);
+        glGenTextures(1, &color);
+        glState.BindTexture(GL_TEXTURE_2D, color);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, targetWidth, targetHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color, 0);
+        gpuMemory.TrackTexture(color, static_cast<size_t>(targetWidth) * targetHeight * 4, GpuMemoryCategory::RenderTarget, "dynamic resolution");
+
+        // Depth with stencil, like the G-buffer, so the deferred path can blit its depth here
+        glGenTextures(1, &depth);
+        glState.BindTexture(GL_TEXTURE_2D, depth);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, targetWidth, targetHeight, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depth, 0);
+        gpuMemory.TrackTexture(depth, static_cast<size_t>(targetWidth) * targetHeight * 4, GpuMemoryCategory::RenderTarget, "dynamic resolution");
+
+        bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        glState.BindFramebuffer(0);
+        if (!complete)
+            std::cerr << "ERROR::DYNAMICRESOLUTION: Framebuffer is not complete" << std::endl;
+        return complete;
+    }
+
+    // Starts timing the frame; the caller renders into GetFramebuffer() at GetRenderSize()
+    void Begin()
+    {
+        timer.Begin();
+    }
+
+    // Stops timing, upscales into the default framebuffer and picks the scale of a later frame
+    void End()
+    {
+        timer.End();
+        glm::ivec2 size = GetRenderSize();
+        GLState& glState = GLState::GetInstance();
+        glState.BindFramebuffer(0);
+        glState.BlitFramebuffer(framebuffer, 0, 0, size.x, size.y, 0, 0, windowWidth, windowHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+        framesSinceChange++;
+        timings.clear();
+        timer.Collect(timings);
+        for (float milliseconds : timings)
+            adjust(milliseconds);
+    }
+
+    GLuint GetFramebuffer() const { return framebuffer; }
+    float GetScale() const { return scale; }
+    float GetGpuMilliseconds() const { return lastMilliseconds; }
+
+    glm::ivec2 GetRenderSize() const
+    {
+        return glm::ivec2(std::clamp(static_cast<GLsizei>(std::lround(windowWidth * scale)), 1, targetWidth),
+            std::clamp(static_cast<GLsizei>(std::lround(windowHeight * scale)), 1, targetHeight));
+    }
+
+private:
+    static constexpr float SMOOTHING = 0.2f; // Weight of each new GPU time in the running average
+    static constexpr float HEADROOM = 0.85f; // Scale back up only below this fraction of the budget
+    static constexpr float MAX_GROWTH = 1.1f; // Per change, so the scale creeps up but drops at once
+    static constexpr float STEP = 1.0f / 32.0f; // Scales are rounded to this, so noise does not resize every frame
+
+    Config config;
+    GpuTimer timer;
+    std::vector<float> timings; // Reused every frame
+    GLuint framebuffer = 0, color = 0, depth = 0;
+    GLsizei windowWidth = 0, windowHeight = 0, targetWidth = 0, targetHeight = 0;
+    float scale = 1.0f;
+    float smoothedMilliseconds = 0.0f;
+    float lastMilliseconds = 0.0f;
+    int framesSinceChange = 0;
+
+    // Pixel count, and roughly GPU time, goes with the square of the scale. Results arrive a few frames
+    // late, so after a change the frames still in flight at the old scale are not acted on.
+    void adjust(float milliseconds)
+    {
+        lastMilliseconds = milliseconds;
+        if (framesSinceChange <= GpuTimer::LATENCY)
+            return;
+        smoothedMilliseconds = smoothedMilliseconds == 0.0f ? milliseconds : glm::mix(smoothedMilliseconds, milliseconds, SMOOTHING);
+        if (smoothedMilliseconds <= 0.0f)
+            return;
+
+        float target = scale;
+        if (smoothedMilliseconds > config.BudgetMilliseconds)
+            target = scale * std::sqrt(config.BudgetMilliseconds / smoothedMilliseconds);
+        else if (smoothedMilliseconds < config.BudgetMilliseconds * HEADROOM)
+            target = scale * std::min(std::sqrt(config.BudgetMilliseconds * HEADROOM / smoothedMilliseconds), MAX_GROWTH);
+        target = std::clamp(std::round(target / STEP) * STEP, config.MinScale, config.MaxScale);
+        if (target == scale)
+            return;
+
+        scale = target;
+        framesSinceChange = 0;
+        smoothedMilliseconds = 0.0f;
+    }
+
+    void release()
+    {
+        if (framebuffer == 0)
+            return;
+        GpuMemory& gpuMemory = GpuMemory::GetInstance();
+        for (GLuint* texture : { &color, &depth })
+        {
+            gpuMemory.ReleaseTexture(*texture);
+            glDeleteTextures(1, texture);
+            *texture = 0;
+        }
+        glDeleteFramebuffers(1, &framebuffer);
+        framebuffer = 0;
+        GLState::GetInstance().Invalidate();
+    }
+};
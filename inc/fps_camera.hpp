@@ -5,6 +5,7 @@
 #include <glm/gtc/constants.hpp>
 #include <glm/gtc/quaternion.hpp>
 
+#include <cmath>
 #include <vector>
 
 // Enumerates camera movement directions.
@@ -143,6 +144,15 @@ public:
         updateCameraVectors();
     }
 
+    // Turns the camera towards a point, e.g. for scripted camera paths.
+    void LookAt(const glm::vec3& target)
+    {
+        glm::vec3 direction = glm::normalize(target - Position);
+        yawAngle = glm::degrees(std::atan2(direction.z, direction.x));
+        pitchAngle = glm::clamp(glm::degrees(std::asin(direction.y)), -80.0f, 80.0f);
+        updateCameraVectors();
+    }
+
 private:
     // Euler Angles
     float yawAngle;
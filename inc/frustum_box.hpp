@@ -1,63 +1,41 @@
 #pragma once
 
-#include "shader.hpp"
+#include "debug_draw.hpp"
+
+#include <glm/glm.hpp>
 
 #include <vector>
 
+// A box given by its 8 corners, e.g. a light frustum; drawn through the batched DebugDraw lines
 class FrustumBox
 {
 public:
     FrustumBox(const std::vector<glm::vec3>& corners, const glm::vec3& color)
-        : corners(corners), color(color)
+        : color(color)
     {
-       loadMesh();
+        SetCorners(corners);
     }
 
-    void Draw(const Shader& shader) const
+    /*-----------------/
+          6------7
+         /|     /|
+        2------3 |
+        | 4----|-5
+        |/     |/
+        0------1
+    /-----------------*/
+    void SetCorners(const std::vector<glm::vec3>& newCorners)
     {
-        shader.Use();
-        shader.SetVec3("color", color);
-        glBindVertexArray(VAO);
-        glDrawElements(GL_LINES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        for (size_t i = 0; i < 8 && i < newCorners.size(); ++i)
+            corners[i] = newCorners[i];
     }
 
-private:
-    GLuint VAO, VBO, EBO = 0;
-    std::vector<GLuint> indices;
-    std::vector<glm::vec3> corners;
-    glm::vec3 color;
-
-    void loadMesh()
+    void Draw() const
     {
-        /*-----------------/
-              6------7
-             /|     /|
-            2------3 |
-            | 4----|-5
-            |/     |/
-            0------1
-        /-----------------*/
-
-        indices = {
-            0, 1, 1, 3, 3, 2, 2, 0, // Near plane CCW
-            4, 5, 5, 7, 7, 6, 6, 4, // Far plane CCW
-            0, 4, 1, 5, 2, 6, 3, 7  // Connect near and far planes
-        };
-
-        // Create VAO/VBO
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
-
-        glBindVertexArray(VAO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, corners.size() * sizeof(glm::vec3), corners.data(), GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
-
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
-        glEnableVertexAttribArray(0);
+        DebugDraw::GetInstance().Box(corners, color);
     }
-};
\ No newline at end of file
+
+private:
+    glm::vec3 corners[8];
+    glm::vec3 color;
+};
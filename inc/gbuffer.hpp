@@ -0,0 +1,116 @@
+#pragma once
+
+#include "gl_state.hpp"
+#include "gpu_memory.hpp"
+#include "shader.hpp"
+
+#include <glad/gl.h>
+
+#include <array>
+#include <iostream>
+
+// Geometry buffer of the deferred path, kept small: albedo with roughness in RGBA8, the normal
+// octahedron-encoded into RG16 snorm, and depth, from which deferred.fs reconstructs the position
+class GBuffer
+{
+public:
+    ~GBuffer()
+    {
+        release();
+    }
+
+    GBuffer() = default;
+    GBuffer(const GBuffer&) = delete;
+    GBuffer& operator=(const GBuffer&) = delete;
+
+    bool Create(GLsizei newWidth, GLsizei newHeight)
+    {
+        release();
+        width = newWidth;
+        height = newHeight;
+        GLState& glState = GLState::GetInstance();
+        glGenFramebuffers(1, &framebuffer);
+        glState.BindFramebuffer(framebuffer);
+        for (size_t i = 0; i < textures.size(); ++i)
+        {
+            glGenTextures(1, &textures[i]);
+            glState.BindTexture(GL_TEXTURE_2D, textures[i]);
+            glTexImage2D(GL_TEXTURE_2D, 0, FORMATS[i].internalFormat, width, height, 0, FORMATS[i].format, FORMATS[i].type, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, FORMATS[i].attachment, GL_TEXTURE_2D, textures[i], 0);
+            GpuMemory::GetInstance().TrackTexture(textures[i], static_cast<size_t>(width) * height * FORMATS[i].bytesPerPixel,
+                GpuMemoryCategory::RenderTarget, "g-buffer");
+        }
+        const GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+        glState.DrawBuffers(2, drawBuffers);
+        bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        glState.BindFramebuffer(0);
+        if (!complete)
+            std::cerr << "ERROR::GBUFFER: Framebuffer is not complete" << std::endl;
+        return complete;
+    }
+
+    GLuint GetFramebuffer() const { return framebuffer; }
+
+    // The buffers on units 0-2 for deferred.fs
+    void Bind(const Shader& shader) const
+    {
+        shader.Use();
+        shader.SetInt("gAlbedoRoughness", 0);
+        shader.SetInt("gNormal", 1);
+        shader.SetInt("gDepth", 2);
+        GLState& glState = GLState::GetInstance();
+        for (GLuint unit = 0; unit < textures.size(); ++unit)
+        {
+            glState.BindTexture(unit, GL_TEXTURE_2D, textures[unit]);
+            glState.BindSampler(unit, 0);
+        }
+    }
+
+    // Copies the depth of the lower-left width x height pixels into target and leaves it bound for drawing,
+    // so what is drawn after the lighting pass is still occluded
+    void BlitDepth(GLuint target, GLsizei blitWidth, GLsizei blitHeight) const
+    {
+        GLState& glState = GLState::GetInstance();
+        glState.BindFramebuffer(target);
+        glState.BlitFramebuffer(framebuffer, 0, 0, blitWidth, blitHeight, 0, 0, blitWidth, blitHeight, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    }
+
+private:
+    struct Format
+    {
+        GLenum attachment;
+        GLint internalFormat;
+        GLenum format, type;
+        size_t bytesPerPixel;
+    };
+
+    // Depth with stencil, to match the default framebuffer for the depth blit
+    static constexpr std::array<Format, 3> FORMATS = { {
+        { GL_COLOR_ATTACHMENT0, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4 },
+        { GL_COLOR_ATTACHMENT1, GL_RG16_SNORM, GL_RG, GL_SHORT, 4 },
+        { GL_DEPTH_STENCIL_ATTACHMENT, GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, 4 },
+    } };
+
+    GLuint framebuffer = 0;
+    std::array<GLuint, 3> textures{};
+    GLsizei width = 0, height = 0;
+
+    void release()
+    {
+        if (framebuffer == 0)
+            return;
+        GpuMemory& gpuMemory = GpuMemory::GetInstance();
+        for (GLuint& texture : textures)
+        {
+            gpuMemory.ReleaseTexture(texture);
+            glDeleteTextures(1, &texture);
+            texture = 0;
+        }
+        glDeleteFramebuffers(1, &framebuffer);
+        framebuffer = 0;
+        GLState::GetInstance().Invalidate();
+    }
+};
@@ -0,0 +1,737 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#ifndef GL_TEXTURE_MAX_ANISOTROPY
+#define GL_TEXTURE_MAX_ANISOTROPY 0x84FE
+#endif
+
+// Record opcodes of a capture file. Resources are snapshots of the objects a frame uses and are
+// replayed once; frame commands are replayed every iteration. Object names are the capturing
+// process's and are remapped on replay.
+enum class GLCommand : uint8_t
+{
+    CreateBuffer,
+    CreateVertexArray,
+    CreateTexture,
+    CreateSampler,
+    CreateProgram,
+    CreateFramebuffer,
+    CreateTextureBuffer,
+
+    Enable,
+    Disable,
+    Viewport,
+    ClearColor,
+    Clear,
+    CullFace,
+    DepthFunc,
+    BlendFunc,
+    UseProgram,
+    BindVertexArray,
+    BindTexture,
+    BindSampler,
+    BindBuffer,
+    BindFramebuffer,
+    DrawBuffers,
+    BlitFramebuffer,
+    BufferSubData,
+    Uniform,
+    DrawElements,
+    DrawArrays,
+    DrawElementsInstanced
+};
+
+enum class GLUniformType : uint8_t
+{
+    Int,
+    Float,
+    Vec2,
+    Vec3,
+    Vec4,
+    Mat2,
+    Mat3,
+    Mat4
+};
+
+// Capture file layout: header, resource records, frame command records. All values are little endian PODs,
+// blobs and strings are prefixed with their uint32 size.
+struct GLCaptureHeader
+{
+    static constexpr uint32_t MAGIC = 0x43524C47; // "GLRC"
+    static constexpr uint32_t VERSION = 4;
+
+    uint32_t magic = MAGIC;
+    uint32_t version = VERSION;
+    uint32_t width = 0, height = 0; // Default framebuffer size
+    uint32_t numCommands = 0;
+    uint32_t numDraws = 0;
+    uint64_t resourceBytes = 0;
+    uint64_t commandBytes = 0;
+};
+
+// Fixed-size parts of vertex array and framebuffer records, written as is
+struct GLCaptureAttribute
+{
+    GLuint index;
+    GLint size, type, normalized, integer, stride, buffer, divisor;
+    uint64_t offset;
+};
+
+struct GLCaptureAttachment
+{
+    GLenum point;
+    GLint type, name; // Texture or renderbuffer
+    GLint format, width, height, samples; // Renderbuffers only
+};
+
+inline GLsizei GLUniformComponents(GLUniformType type)
+{
+    switch (type)
+    {
+    case GLUniformType::Vec2: return 2;
+    case GLUniformType::Vec3: return 3;
+    case GLUniformType::Vec4: return 4;
+    case GLUniformType::Mat2: return 4;
+    case GLUniformType::Mat3: return 9;
+    case GLUniformType::Mat4: return 16;
+    default:                  return 1;
+    }
+}
+
+// Float color formats are captured as RGBA32F instead of RGBA8, e.g. data textures such as baked animations
+inline bool GLIsFloatFormat(GLint format)
+{
+    return format == GL_RGBA16F || format == GL_RGBA32F || format == GL_RGB16F || format == GL_RGB32F
+        || format == GL_RG16F || format == GL_RG32F || format == GL_R16F || format == GL_R32F;
+}
+
+// Captures one frame of GL commands into a binary log for gl-replay. GLState and Shader report every
+// state change, uniform and draw while recording; objects are snapshotted (read back) at the first draw
+// after they are bound, when they are fully set up, so the log does not depend on the app's assets.
+class GLRecorder
+{
+public:
+    static GLRecorder& GetInstance()
+    {
+        static GLRecorder instance;
+        return instance;
+    }
+
+    bool IsRecording() const { return recording; }
+
+    // Binds are only reported when issued, so GLState must be invalidated right before this
+    void BeginCapture(GLsizei width, GLsizei height)
+    {
+        resources.clear();
+        commands.clear();
+        captured.clear();
+        pending.clear();
+        header = GLCaptureHeader();
+        header.width = static_cast<uint32_t>(width);
+        header.height = static_cast<uint32_t>(height);
+        recording = true;
+        recordFixedState();
+    }
+
+    bool EndCapture(const std::string& path)
+    {
+        recording = false;
+        header.resourceBytes = resources.size();
+        header.commandBytes = commands.size();
+
+        std::ofstream file(path, std::ios::binary);
+        if (!file)
+        {
+            std::cerr << "ERROR::GLRECORDER: Failed to write capture: " << path << std::endl;
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(resources.data()), resources.size());
+        file.write(reinterpret_cast<const char*>(commands.data()), commands.size());
+
+        std::cout << "Captured " << header.numCommands << " GL commands (" << header.numDraws << " draws, "
+                  << (resources.size() + commands.size()) / 1024 << " KB) to " << path << std::endl;
+        return true;
+    }
+
+    void Enable(GLenum capability, bool enabled)
+    {
+        command(enabled ? GLCommand::Enable : GLCommand::Disable);
+        put(commands, capability);
+    }
+
+    void Viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+    {
+        command(GLCommand::Viewport);
+        put(commands, x); put(commands, y); put(commands, width); put(commands, height);
+    }
+
+    void ClearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a)
+    {
+        command(GLCommand::ClearColor);
+        put(commands, r); put(commands, g); put(commands, b); put(commands, a);
+    }
+
+    void Clear(GLbitfield mask)
+    {
+        command(GLCommand::Clear);
+        put(commands, mask);
+    }
+
+    void CullFace(GLenum mode)
+    {
+        command(GLCommand::CullFace);
+        put(commands, mode);
+    }
+
+    void UseProgram(GLuint program)
+    {
+        command(GLCommand::UseProgram);
+        put(commands, program);
+        reference(Object::Program, program);
+    }
+
+    void BindVertexArray(GLuint vao)
+    {
+        command(GLCommand::BindVertexArray);
+        put(commands, vao);
+        reference(Object::VertexArray, vao);
+    }
+
+    void BindTexture(GLuint unit, GLenum target, GLuint texture)
+    {
+        command(GLCommand::BindTexture);
+        put(commands, unit); put(commands, target); put(commands, texture);
+        reference(Object::Texture, texture, target);
+    }
+
+    void BindSampler(GLuint unit, GLuint sampler)
+    {
+        command(GLCommand::BindSampler);
+        put(commands, unit); put(commands, sampler);
+        reference(Object::Sampler, sampler);
+    }
+
+    void BindBuffer(GLenum target, GLuint buffer)
+    {
+        command(GLCommand::BindBuffer);
+        put(commands, target); put(commands, buffer);
+        reference(Object::Buffer, buffer);
+    }
+
+    void BindFramebuffer(GLuint framebuffer)
+    {
+        command(GLCommand::BindFramebuffer);
+        put(commands, framebuffer);
+        reference(Object::Framebuffer, framebuffer);
+    }
+
+    void DrawBuffers(GLsizei count, const GLenum* buffers)
+    {
+        command(GLCommand::DrawBuffers);
+        putBlob(commands, buffers, sizeof(GLenum) * static_cast<size_t>(count));
+    }
+
+    // Reads from source into the bound draw framebuffer. Snapshots like a draw, as a blit may end the frame.
+    void BlitFramebuffer(GLuint source, const std::array<GLint, 8>& rectangles, GLbitfield mask, GLenum filter)
+    {
+        reference(Object::Framebuffer, source);
+        flush();
+        command(GLCommand::BlitFramebuffer);
+        put(commands, source); put(commands, mask); put(commands, filter);
+        putBlob(commands, rectangles.data(), sizeof(rectangles));
+    }
+
+    // Per-frame buffer updates, e.g. streamed vertices; static uploads are covered by the snapshots
+    void BufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+    {
+        command(GLCommand::BufferSubData);
+        put(commands, target); put(commands, static_cast<uint64_t>(offset));
+        putBlob(commands, data, static_cast<size_t>(size));
+    }
+
+    // Locations are the capturing program's, replay maps them through the uniform names of the snapshot
+    void Uniform(GLint location, GLUniformType type, GLsizei count, const void* data)
+    {
+        if (location < 0)
+            return;
+        command(GLCommand::Uniform);
+        put(commands, location); put(commands, type); put(commands, count);
+        putBlob(commands, data, sizeof(GLfloat) * GLUniformComponents(type) * count);
+    }
+
+    void DrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+    {
+        flush();
+        command(GLCommand::DrawElements);
+        put(commands, mode); put(commands, count); put(commands, type);
+        put(commands, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(indices)));
+        header.numDraws++;
+    }
+
+    void DrawArrays(GLenum mode, GLint first, GLsizei count)
+    {
+        flush();
+        command(GLCommand::DrawArrays);
+        put(commands, mode); put(commands, first); put(commands, count);
+        header.numDraws++;
+    }
+
+    void DrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instances)
+    {
+        flush();
+        command(GLCommand::DrawElementsInstanced);
+        put(commands, mode); put(commands, count); put(commands, type);
+        put(commands, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(indices)));
+        put(commands, instances);
+        header.numDraws++;
+    }
+
+private:
+    enum class Object : uint8_t
+    {
+        Buffer,
+        VertexArray,
+        Texture,
+        Sampler,
+        Program,
+        Framebuffer
+    };
+
+    struct PendingObject
+    {
+        Object type;
+        GLuint name;
+        GLenum target;
+    };
+
+    bool recording = false;
+    GLCaptureHeader header;
+    std::vector<uint8_t> resources;
+    std::vector<uint8_t> commands;
+    std::unordered_set<uint64_t> captured;
+    std::vector<PendingObject> pending;
+
+    GLRecorder() {}
+    GLRecorder(const GLRecorder&) = delete;
+    GLRecorder& operator=(const GLRecorder&) = delete;
+
+    template<typename T>
+    static void put(std::vector<uint8_t>& out, const T& value)
+    {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    static void putBlob(std::vector<uint8_t>& out, const void* data, size_t size)
+    {
+        put(out, static_cast<uint32_t>(size));
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        if (size > 0)
+            out.insert(out.end(), bytes, bytes + size);
+    }
+
+    static void putString(std::vector<uint8_t>& out, const std::string& text) { putBlob(out, text.data(), text.size()); }
+
+    void command(GLCommand op)
+    {
+        put(commands, op);
+        header.numCommands++;
+    }
+
+    static uint64_t key(Object type, GLuint name) { return (static_cast<uint64_t>(type) << 32) | name; }
+
+    void reference(Object type, GLuint name, GLenum target = 0)
+    {
+        if (name != 0 && !captured.count(key(type, name)))
+            pending.push_back({ type, name, target });
+    }
+
+    // State set before the frame that the frame relies on
+    void recordFixedState()
+    {
+        for (GLenum capability : { GL_DEPTH_TEST, GL_CULL_FACE, GL_BLEND })
+            Enable(capability, glIsEnabled(capability) == GL_TRUE);
+
+        GLint viewport[4], cullFace, depthFunc, blendSrc, blendDst, framebuffer;
+        GLfloat clearColor[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        glGetIntegerv(GL_CULL_FACE_MODE, &cullFace);
+        glGetIntegerv(GL_DEPTH_FUNC, &depthFunc);
+        glGetIntegerv(GL_BLEND_SRC_RGB, &blendSrc);
+        glGetIntegerv(GL_BLEND_DST_RGB, &blendDst);
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+        glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+
+        Viewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        CullFace(static_cast<GLenum>(cullFace));
+        command(GLCommand::DepthFunc);
+        put(commands, static_cast<GLenum>(depthFunc));
+        command(GLCommand::BlendFunc);
+        put(commands, static_cast<GLenum>(blendSrc)); put(commands, static_cast<GLenum>(blendDst));
+        ClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+        BindFramebuffer(static_cast<GLuint>(framebuffer));
+    }
+
+    // Snapshots everything referenced since the last draw
+    void flush()
+    {
+        std::vector<PendingObject> objects;
+        objects.swap(pending);
+        for (const auto& object : objects)
+            snapshot(object.type, object.name, object.target);
+    }
+
+    void snapshot(Object type, GLuint name, GLenum target = 0)
+    {
+        if (name == 0 || !captured.insert(key(type, name)).second)
+            return;
+        switch (type)
+        {
+        case Object::Buffer:      snapshotBuffer(name); break;
+        case Object::VertexArray: snapshotVertexArray(name); break;
+        case Object::Texture:     snapshotTexture(target, name); break;
+        case Object::Sampler:     snapshotSampler(name); break;
+        case Object::Program:     snapshotProgram(name); break;
+        case Object::Framebuffer: snapshotFramebuffer(name); break;
+        }
+    }
+
+    // Read back through GL_COPY_READ_BUFFER, which nothing else binds
+    void snapshotBuffer(GLuint buffer)
+    {
+        if (!glIsBuffer(buffer))
+            return;
+        GLint previous;
+        glGetIntegerv(GL_COPY_READ_BUFFER_BINDING, &previous);
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        GLint64 size = 0;
+        GLint usage = GL_STATIC_DRAW;
+        glGetBufferParameteri64v(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+        glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_USAGE, &usage);
+        std::vector<uint8_t> data(static_cast<size_t>(size));
+        if (size > 0)
+            glGetBufferSubData(GL_COPY_READ_BUFFER, 0, size, data.data());
+        glBindBuffer(GL_COPY_READ_BUFFER, previous);
+
+        put(resources, GLCommand::CreateBuffer);
+        put(resources, buffer);
+        put(resources, static_cast<GLenum>(usage));
+        putBlob(resources, data.data(), data.size());
+    }
+
+    void snapshotVertexArray(GLuint vao)
+    {
+        GLint previous, elementBuffer, maxAttributes;
+        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previous);
+        glBindVertexArray(vao);
+        glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &elementBuffer);
+        glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &maxAttributes);
+        std::vector<GLCaptureAttribute> attributes;
+        for (GLint i = 0; i < maxAttributes; ++i)
+        {
+            GLint enabled = 0;
+            glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_ENABLED, &enabled);
+            if (!enabled)
+                continue;
+            GLCaptureAttribute attribute{};
+            attribute.index = static_cast<GLuint>(i);
+            void* pointer = nullptr;
+            glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_SIZE, &attribute.size);
+            glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_TYPE, &attribute.type);
+            glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_NORMALIZED, &attribute.normalized);
+            glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_INTEGER, &attribute.integer);
+            glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_STRIDE, &attribute.stride);
+            glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &attribute.buffer);
+            glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_DIVISOR, &attribute.divisor);
+            glGetVertexAttribPointerv(i, GL_VERTEX_ATTRIB_ARRAY_POINTER, &pointer);
+            attribute.offset = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(pointer));
+            attributes.push_back(attribute);
+        }
+        glBindVertexArray(previous);
+
+        // Buffers first, replay creates resources in file order
+        snapshot(Object::Buffer, static_cast<GLuint>(elementBuffer));
+        for (const auto& attribute : attributes)
+            snapshot(Object::Buffer, static_cast<GLuint>(attribute.buffer));
+
+        put(resources, GLCommand::CreateVertexArray);
+        put(resources, vao);
+        put(resources, static_cast<GLuint>(elementBuffer));
+        put(resources, static_cast<uint32_t>(attributes.size()));
+        for (const auto& attribute : attributes)
+            put(resources, attribute);
+    }
+
+    static bool isDepthFormat(GLint format)
+    {
+        return format == GL_DEPTH_COMPONENT || format == GL_DEPTH_COMPONENT16 || format == GL_DEPTH_COMPONENT24
+            || format == GL_DEPTH_COMPONENT32F || format == GL_DEPTH_STENCIL || format == GL_DEPTH24_STENCIL8
+            || format == GL_DEPTH32F_STENCIL8;
+    }
+
+    // Color levels are read back as RGBA8, or RGBA32F for float formats; depth textures are render targets and only get their storage
+    void snapshotTexture(GLenum target, GLuint texture)
+    {
+        if (target == GL_TEXTURE_BUFFER)
+        {
+            snapshotTextureBuffer(texture);
+            return;
+        }
+        if (target != GL_TEXTURE_2D && target != GL_TEXTURE_2D_ARRAY)
+        {
+            std::cerr << "ERROR::GLRECORDER: Unsupported texture target: " << target << std::endl;
+            return;
+        }
+        GLint previous;
+        glGetIntegerv(target == GL_TEXTURE_2D ? GL_TEXTURE_BINDING_2D : GL_TEXTURE_BINDING_2D_ARRAY, &previous);
+        glBindTexture(target, texture);
+
+        GLint internalFormat, maxLevel, params[6];
+        GLfloat borderColor[4];
+        glGetTexLevelParameteriv(target, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+        glGetTexParameteriv(target, GL_TEXTURE_MAX_LEVEL, &maxLevel);
+        glGetTexParameteriv(target, GL_TEXTURE_MIN_FILTER, &params[0]);
+        glGetTexParameteriv(target, GL_TEXTURE_MAG_FILTER, &params[1]);
+        glGetTexParameteriv(target, GL_TEXTURE_WRAP_S, &params[2]);
+        glGetTexParameteriv(target, GL_TEXTURE_WRAP_T, &params[3]);
+        glGetTexParameteriv(target, GL_TEXTURE_COMPARE_MODE, &params[4]);
+        glGetTexParameteriv(target, GL_TEXTURE_COMPARE_FUNC, &params[5]);
+        glGetTexParameterfv(target, GL_TEXTURE_BORDER_COLOR, borderColor);
+        bool depth = isDepthFormat(internalFormat);
+        bool floating = GLIsFloatFormat(internalFormat);
+
+        std::vector<std::vector<uint8_t>> levels;
+        std::vector<GLint> sizes;
+        for (GLint level = 0; level <= maxLevel && level < 16; ++level)
+        {
+            GLint width = 0, height = 0, layers = 1;
+            glGetTexLevelParameteriv(target, level, GL_TEXTURE_WIDTH, &width);
+            glGetTexLevelParameteriv(target, level, GL_TEXTURE_HEIGHT, &height);
+            if (target == GL_TEXTURE_2D_ARRAY)
+                glGetTexLevelParameteriv(target, level, GL_TEXTURE_DEPTH, &layers);
+            if (width == 0 || height == 0)
+                break;
+            std::vector<uint8_t> pixels;
+            if (!depth)
+            {
+                pixels.resize(static_cast<size_t>(width) * height * layers * 4 * (floating ? sizeof(GLfloat) : 1));
+                glGetTexImage(target, level, GL_RGBA, floating ? GL_FLOAT : GL_UNSIGNED_BYTE, pixels.data());
+            }
+            sizes.insert(sizes.end(), { width, height, layers });
+            levels.push_back(std::move(pixels));
+        }
+        glBindTexture(target, previous);
+
+        put(resources, GLCommand::CreateTexture);
+        put(resources, texture);
+        put(resources, target);
+        put(resources, internalFormat);
+        put(resources, params);
+        put(resources, borderColor);
+        put(resources, static_cast<uint32_t>(levels.size()));
+        for (size_t level = 0; level < levels.size(); ++level)
+        {
+            put(resources, sizes[level * 3 + 0]);
+            put(resources, sizes[level * 3 + 1]);
+            put(resources, sizes[level * 3 + 2]);
+            putBlob(resources, levels[level].data(), levels[level].size());
+        }
+    }
+
+    // A buffer texture is only a view: its buffer is captured as any other, plus the format it is read as
+    void snapshotTextureBuffer(GLuint texture)
+    {
+        GLint previous, buffer = 0, internalFormat = GL_R32F;
+        glGetIntegerv(GL_TEXTURE_BINDING_BUFFER, &previous);
+        glBindTexture(GL_TEXTURE_BUFFER, texture);
+        glGetIntegerv(GL_TEXTURE_BUFFER_DATA_STORE_BINDING, &buffer);
+        glGetTexLevelParameteriv(GL_TEXTURE_BUFFER, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+        glBindTexture(GL_TEXTURE_BUFFER, previous);
+
+        snapshot(Object::Buffer, static_cast<GLuint>(buffer));
+
+        put(resources, GLCommand::CreateTextureBuffer);
+        put(resources, texture);
+        put(resources, internalFormat);
+        put(resources, static_cast<GLuint>(buffer));
+    }
+
+    void snapshotSampler(GLuint sampler)
+    {
+        GLint params[5];
+        GLfloat anisotropy = 1.0f;
+        glGetSamplerParameteriv(sampler, GL_TEXTURE_MIN_FILTER, &params[0]);
+        glGetSamplerParameteriv(sampler, GL_TEXTURE_MAG_FILTER, &params[1]);
+        glGetSamplerParameteriv(sampler, GL_TEXTURE_WRAP_S, &params[2]);
+        glGetSamplerParameteriv(sampler, GL_TEXTURE_WRAP_T, &params[3]);
+        glGetSamplerParameteriv(sampler, GL_TEXTURE_COMPARE_MODE, &params[4]);
+        glGetSamplerParameterfv(sampler, GL_TEXTURE_MAX_ANISOTROPY, &anisotropy);
+        if (glGetError() != GL_NO_ERROR)
+            anisotropy = 1.0f; // Extension not available
+
+        put(resources, GLCommand::CreateSampler);
+        put(resources, sampler);
+        put(resources, params);
+        put(resources, anisotropy);
+    }
+
+    static bool toUniformType(GLenum glType, GLUniformType& type)
+    {
+        switch (glType)
+        {
+        case GL_FLOAT:        type = GLUniformType::Float; return true;
+        case GL_FLOAT_VEC2:   type = GLUniformType::Vec2; return true;
+        case GL_FLOAT_VEC3:   type = GLUniformType::Vec3; return true;
+        case GL_FLOAT_VEC4:   type = GLUniformType::Vec4; return true;
+        case GL_FLOAT_MAT2:   type = GLUniformType::Mat2; return true;
+        case GL_FLOAT_MAT3:   type = GLUniformType::Mat3; return true;
+        case GL_FLOAT_MAT4:   type = GLUniformType::Mat4; return true;
+        case GL_INT:
+        case GL_BOOL:
+        case GL_SAMPLER_2D:
+        case GL_SAMPLER_2D_ARRAY:
+        case GL_SAMPLER_2D_SHADOW:
+        case GL_SAMPLER_BUFFER:
+        case GL_INT_SAMPLER_BUFFER:
+        case GL_UNSIGNED_INT_SAMPLER_BUFFER:
+                              type = GLUniformType::Int; return true;
+        default:              return false;
+        }
+    }
+
+    // Shader sources come from the attached (already deleted, still alive) shaders; uniform values set
+    // before the frame come from the program itself
+    void snapshotProgram(GLuint program)
+    {
+        GLint numShaders = 0;
+        glGetProgramiv(program, GL_ATTACHED_SHADERS, &numShaders);
+        std::vector<GLuint> shaders(numShaders);
+        if (numShaders > 0)
+            glGetAttachedShaders(program, numShaders, nullptr, shaders.data());
+
+        put(resources, GLCommand::CreateProgram);
+        put(resources, program);
+        put(resources, static_cast<uint32_t>(shaders.size()));
+        for (GLuint shader : shaders)
+        {
+            GLint type = 0, length = 0;
+            glGetShaderiv(shader, GL_SHADER_TYPE, &type);
+            glGetShaderiv(shader, GL_SHADER_SOURCE_LENGTH, &length);
+            std::string source(static_cast<size_t>(length), '\0');
+            if (length > 0)
+                glGetShaderSource(shader, length, nullptr, source.data());
+            source.resize(std::strlen(source.c_str()));
+            put(resources, static_cast<GLenum>(type));
+            putString(resources, source);
+        }
+
+        struct Value
+        {
+            std::string name;
+            GLint location;
+            GLUniformType type;
+            GLfloat data[16];
+        };
+        std::vector<Value> values;
+        GLint numUniforms = 0, maxLength = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &numUniforms);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<GLchar> nameBuffer(static_cast<size_t>(maxLength) + 1);
+        for (GLint i = 0; i < numUniforms; ++i)
+        {
+            GLint size = 0;
+            GLenum glType = 0;
+            glGetActiveUniform(program, i, static_cast<GLsizei>(nameBuffer.size()), nullptr, &size, &glType, nameBuffer.data());
+            GLUniformType type;
+            if (!toUniformType(glType, type))
+                continue;
+            std::string name = nameBuffer.data();
+            if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+                name.resize(name.size() - 3);
+            for (GLint element = 0; element < size; ++element)
+            {
+                Value value = { size > 1 ? name + "[" + std::to_string(element) + "]" : name, -1, type, {} };
+                value.location = glGetUniformLocation(program, value.name.c_str());
+                if (value.location < 0)
+                    continue; // In a uniform block
+                if (type == GLUniformType::Int)
+                    glGetUniformiv(program, value.location, reinterpret_cast<GLint*>(value.data));
+                else
+                    glGetUniformfv(program, value.location, value.data);
+                values.push_back(std::move(value));
+            }
+        }
+
+        put(resources, static_cast<uint32_t>(values.size()));
+        for (const auto& value : values)
+        {
+            putString(resources, value.name);
+            put(resources, value.location);
+            put(resources, value.type);
+            putBlob(resources, value.data, sizeof(GLfloat) * GLUniformComponents(value.type));
+        }
+    }
+
+    void snapshotFramebuffer(GLuint framebuffer)
+    {
+        GLint previous, maxColorAttachments;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous);
+        glGetIntegerv(GL_MAX_COLOR_ATTACHMENTS, &maxColorAttachments);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+
+        std::vector<GLenum> points = { GL_DEPTH_ATTACHMENT, GL_STENCIL_ATTACHMENT };
+        for (GLint i = 0; i < maxColorAttachments && i < 8; ++i)
+            points.push_back(GL_COLOR_ATTACHMENT0 + i);
+        std::vector<GLCaptureAttachment> attachments;
+        for (GLenum point : points)
+        {
+            GLCaptureAttachment attachment = { point, GL_NONE, 0, 0, 0, 0, 0 };
+            glGetFramebufferAttachmentParameteriv(GL_DRAW_FRAMEBUFFER, point, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE, &attachment.type);
+            if (attachment.type == GL_NONE)
+                continue;
+            glGetFramebufferAttachmentParameteriv(GL_DRAW_FRAMEBUFFER, point, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME, &attachment.name);
+            if (attachment.type == GL_RENDERBUFFER)
+            {
+                GLint previousRenderbuffer;
+                glGetIntegerv(GL_RENDERBUFFER_BINDING, &previousRenderbuffer);
+                glBindRenderbuffer(GL_RENDERBUFFER, attachment.name);
+                glGetRenderbufferParameteriv(GL_RENDERBUFFER, GL_RENDERBUFFER_INTERNAL_FORMAT, &attachment.format);
+                glGetRenderbufferParameteriv(GL_RENDERBUFFER, GL_RENDERBUFFER_WIDTH, &attachment.width);
+                glGetRenderbufferParameteriv(GL_RENDERBUFFER, GL_RENDERBUFFER_HEIGHT, &attachment.height);
+                glGetRenderbufferParameteriv(GL_RENDERBUFFER, GL_RENDERBUFFER_SAMPLES, &attachment.samples);
+                glBindRenderbuffer(GL_RENDERBUFFER, previousRenderbuffer);
+            }
+            attachments.push_back(attachment);
+        }
+        std::vector<GLint> drawBuffers(static_cast<size_t>(std::min(maxColorAttachments, 8)));
+        for (size_t i = 0; i < drawBuffers.size(); ++i)
+            glGetIntegerv(GL_DRAW_BUFFER0 + static_cast<GLenum>(i), &drawBuffers[i]);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previous);
+
+        for (const auto& attachment : attachments)
+            if (attachment.type == GL_TEXTURE)
+                snapshot(Object::Texture, static_cast<GLuint>(attachment.name), GL_TEXTURE_2D);
+
+        put(resources, GLCommand::CreateFramebuffer);
+        put(resources, framebuffer);
+        put(resources, static_cast<uint32_t>(attachments.size()));
+        for (const auto& attachment : attachments)
+            put(resources, attachment);
+        put(resources, static_cast<uint32_t>(drawBuffers.size()));
+        for (GLint drawBuffer : drawBuffers)
+            put(resources, drawBuffer);
+    }
+};
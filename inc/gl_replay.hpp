@@ -0,0 +1,637 @@
+#pragma once
+
+#include "gl_recorder.hpp"
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Re-executes a GLRecorder capture in the current context. Resources are created once, frame commands are
+// decoded up front into a flat list with remapped names, so Run only measures GL submission. The captured
+// default framebuffer is replaced by an offscreen one of the same size, so a hidden window is enough.
+class GLReplay
+{
+public:
+    struct Result
+    {
+        unsigned int Iterations = 0;
+        double SubmitMs = 0.0;    // CPU time to issue one frame, average
+        double MinSubmitMs = 0.0;
+        double MaxSubmitMs = 0.0;
+        double GpuMs = 0.0;       // GL_TIME_ELAPSED of one frame, average
+    };
+
+    ~GLReplay() { Release(); }
+
+    bool Load(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+        {
+            std::cerr << "ERROR::GLREPLAY: Failed to open capture: " << path << std::endl;
+            return false;
+        }
+        bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        if (bytes.size() < sizeof(header))
+        {
+            std::cerr << "ERROR::GLREPLAY: Truncated capture: " << path << std::endl;
+            return false;
+        }
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        if (header.magic != GLCaptureHeader::MAGIC || header.version != GLCaptureHeader::VERSION
+            || sizeof(header) + header.resourceBytes + header.commandBytes > bytes.size())
+        {
+            std::cerr << "ERROR::GLREPLAY: Not a capture or unsupported version: " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Needs a current context; creates the snapshotted objects and decodes the frame
+    bool CreateResources()
+    {
+        createDefaultFramebuffer();
+
+        cursor = sizeof(header);
+        const size_t resourceEnd = cursor + header.resourceBytes;
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        while (cursor < resourceEnd && valid)
+        {
+            switch (get<GLCommand>())
+            {
+            case GLCommand::CreateBuffer:        createBuffer(); break;
+            case GLCommand::CreateVertexArray:   createVertexArray(); break;
+            case GLCommand::CreateTexture:       createTexture(); break;
+            case GLCommand::CreateSampler:       createSampler(); break;
+            case GLCommand::CreateProgram:       createProgram(); break;
+            case GLCommand::CreateFramebuffer:   createFramebuffer(); break;
+            case GLCommand::CreateTextureBuffer: createTextureBuffer(); break;
+            default:
+                std::cerr << "ERROR::GLREPLAY: Unexpected command in resources" << std::endl;
+                valid = false;
+            }
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        decodeFrame(resourceEnd + header.commandBytes);
+        return valid;
+    }
+
+    Result Run(unsigned int iterations)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        Result result;
+        result.Iterations = iterations;
+        result.MinSubmitMs = 1e9;
+        if (iterations == 0)
+            return result;
+
+        // Warm up driver caches and shader variants
+        execute();
+        glFinish();
+
+        GLuint query;
+        glGenQueries(1, &query);
+        for (unsigned int i = 0; i < iterations; ++i)
+        {
+            auto start = Clock::now();
+            glBeginQuery(GL_TIME_ELAPSED, query);
+            execute();
+            glEndQuery(GL_TIME_ELAPSED);
+            double submitMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+            // Waiting for the result also keeps iterations from overlapping
+            GLuint64 gpuNs = 0;
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &gpuNs);
+
+            result.SubmitMs += submitMs;
+            result.MinSubmitMs = std::min(result.MinSubmitMs, submitMs);
+            result.MaxSubmitMs = std::max(result.MaxSubmitMs, submitMs);
+            result.GpuMs += gpuNs / 1e6;
+        }
+        glDeleteQueries(1, &query);
+
+        result.SubmitMs /= iterations;
+        result.GpuMs /= iterations;
+        return result;
+    }
+
+    void Release()
+    {
+        for (const auto& [captured, name] : buffers)       glDeleteBuffers(1, &name);
+        for (const auto& [captured, name] : vertexArrays)  glDeleteVertexArrays(1, &name);
+        for (const auto& [captured, name] : textures)      glDeleteTextures(1, &name);
+        for (const auto& [captured, name] : samplers)      glDeleteSamplers(1, &name);
+        for (const auto& [captured, name] : programs)      glDeleteProgram(name);
+        for (const auto& [captured, name] : framebuffers)  glDeleteFramebuffers(1, &name);
+        glDeleteRenderbuffers(static_cast<GLsizei>(renderbuffers.size()), renderbuffers.data());
+        buffers.clear(); vertexArrays.clear(); textures.clear(); samplers.clear(); programs.clear(); framebuffers.clear();
+        renderbuffers.clear();
+        ops.clear();
+    }
+
+    const GLCaptureHeader& GetHeader() const { return header; }
+
+private:
+    // A decoded frame command; data points into the loaded file
+    struct Op
+    {
+        GLCommand command;
+        GLuint args[4];
+        uint64_t offset;
+        const void* data;
+    };
+
+    std::vector<uint8_t> bytes;
+    GLCaptureHeader header;
+    size_t cursor = 0;
+    bool valid = true;
+    std::vector<Op> ops;
+
+    // Captured name -> replay name
+    std::unordered_map<GLuint, GLuint> buffers, vertexArrays, textures, samplers, programs, framebuffers;
+    // Captured program -> captured uniform location -> replay location
+    std::unordered_map<GLuint, std::unordered_map<GLint, GLint>> uniformLocations;
+    std::vector<GLuint> renderbuffers;
+
+    template<typename T>
+    T get()
+    {
+        T value{};
+        if (cursor + sizeof(T) > bytes.size())
+        {
+            valid = false;
+            return value;
+        }
+        std::memcpy(&value, bytes.data() + cursor, sizeof(T));
+        cursor += sizeof(T);
+        return value;
+    }
+
+    // Returns a pointer into the file and advances past the blob
+    const uint8_t* getBlob(uint32_t& size)
+    {
+        size = get<uint32_t>();
+        if (!valid || cursor + size > bytes.size())
+        {
+            valid = false;
+            size = 0;
+            return nullptr;
+        }
+        const uint8_t* data = bytes.data() + cursor;
+        cursor += size;
+        return data;
+    }
+
+    std::string getString()
+    {
+        uint32_t size;
+        const uint8_t* data = getBlob(size);
+        return data ? std::string(reinterpret_cast<const char*>(data), size) : std::string();
+    }
+
+    static GLuint remap(const std::unordered_map<GLuint, GLuint>& names, GLuint captured)
+    {
+        auto it = names.find(captured);
+        return it != names.end() ? it->second : 0;
+    }
+
+    // Stands in for the window's framebuffer, captured as name 0
+    void createDefaultFramebuffer()
+    {
+        GLuint framebuffer, color, depth;
+        glGenFramebuffers(1, &framebuffer);
+        glGenRenderbuffers(1, &color);
+        glGenRenderbuffers(1, &depth);
+        glBindRenderbuffer(GL_RENDERBUFFER, color);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, header.width, header.height);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, header.width, header.height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        framebuffers[0] = framebuffer;
+        renderbuffers.insert(renderbuffers.end(), { color, depth });
+    }
+
+    void createBuffer()
+    {
+        GLuint captured = get<GLuint>();
+        GLenum usage = get<GLenum>();
+        uint32_t size;
+        const uint8_t* data = getBlob(size);
+
+        GLuint& buffer = buffers[captured];
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, size, data, usage);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    void createVertexArray()
+    {
+        GLuint captured = get<GLuint>();
+        GLuint elementBuffer = get<GLuint>();
+        uint32_t numAttributes = get<uint32_t>();
+
+        GLuint& vao = vertexArrays[captured];
+        glGenVertexArrays(1, &vao);
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, remap(buffers, elementBuffer));
+        for (uint32_t i = 0; i < numAttributes && valid; ++i)
+        {
+            GLCaptureAttribute attribute = get<GLCaptureAttribute>();
+            const void* offset = reinterpret_cast<const void*>(static_cast<uintptr_t>(attribute.offset));
+            glBindBuffer(GL_ARRAY_BUFFER, remap(buffers, static_cast<GLuint>(attribute.buffer)));
+            if (attribute.integer)
+                glVertexAttribIPointer(attribute.index, attribute.size, attribute.type, attribute.stride, offset);
+            else
+                glVertexAttribPointer(attribute.index, attribute.size, attribute.type, static_cast<GLboolean>(attribute.normalized),
+                    attribute.stride, offset);
+            glVertexAttribDivisor(attribute.index, static_cast<GLuint>(attribute.divisor));
+            glEnableVertexAttribArray(attribute.index);
+        }
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void createTexture()
+    {
+        GLuint captured = get<GLuint>();
+        GLenum target = get<GLenum>();
+        GLint internalFormat = get<GLint>();
+        GLint params[6];
+        GLfloat borderColor[4];
+        for (GLint& param : params)
+            param = get<GLint>();
+        for (GLfloat& component : borderColor)
+            component = get<GLfloat>();
+        uint32_t numLevels = get<uint32_t>();
+
+        GLuint& texture = textures[captured];
+        glGenTextures(1, &texture);
+        glBindTexture(target, texture);
+        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, params[0]);
+        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, params[1]);
+        glTexParameteri(target, GL_TEXTURE_WRAP_S, params[2]);
+        glTexParameteri(target, GL_TEXTURE_WRAP_T, params[3]);
+        glTexParameteri(target, GL_TEXTURE_COMPARE_MODE, params[4]);
+        glTexParameteri(target, GL_TEXTURE_COMPARE_FUNC, params[5]);
+        glTexParameterfv(target, GL_TEXTURE_BORDER_COLOR, borderColor);
+        glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, numLevels > 0 ? static_cast<GLint>(numLevels - 1) : 0);
+
+        bool depthStencil = internalFormat == GL_DEPTH_STENCIL || internalFormat == GL_DEPTH24_STENCIL8
+            || internalFormat == GL_DEPTH32F_STENCIL8;
+        for (uint32_t level = 0; level < numLevels && valid; ++level)
+        {
+            GLint width = get<GLint>(), height = get<GLint>(), layers = get<GLint>();
+            uint32_t size;
+            const uint8_t* pixels = getBlob(size);
+            // Depth levels carry no pixels
+            GLenum format = size > 0 ? GL_RGBA : depthStencil ? GL_DEPTH_STENCIL : GL_DEPTH_COMPONENT;
+            GLenum type = size > 0 ? (GLIsFloatFormat(internalFormat) ? GL_FLOAT : GL_UNSIGNED_BYTE)
+                : depthStencil ? GL_UNSIGNED_INT_24_8 : GL_FLOAT;
+            if (target == GL_TEXTURE_2D_ARRAY)
+                glTexImage3D(target, level, internalFormat, width, height, layers, 0, format, type, size > 0 ? pixels : nullptr);
+            else
+                glTexImage2D(target, level, internalFormat, width, height, 0, format, type, size > 0 ? pixels : nullptr);
+        }
+        glBindTexture(target, 0);
+    }
+
+    void createTextureBuffer()
+    {
+        GLuint captured = get<GLuint>();
+        GLint internalFormat = get<GLint>();
+        GLuint buffer = get<GLuint>();
+
+        GLuint& texture = textures[captured];
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_BUFFER, texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, static_cast<GLenum>(internalFormat), remap(buffers, buffer));
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+
+    void createSampler()
+    {
+        GLuint captured = get<GLuint>();
+        GLint params[5];
+        for (GLint& param : params)
+            param = get<GLint>();
+        GLfloat anisotropy = get<GLfloat>();
+
+        GLuint& sampler = samplers[captured];
+        glGenSamplers(1, &sampler);
+        glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, params[0]);
+        glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, params[1]);
+        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, params[2]);
+        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, params[3]);
+        glSamplerParameteri(sampler, GL_TEXTURE_COMPARE_MODE, params[4]);
+        if (anisotropy > 1.0f)
+            glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY, anisotropy);
+    }
+
+    void createProgram()
+    {
+        GLuint captured = get<GLuint>();
+        uint32_t numShaders = get<uint32_t>();
+
+        GLuint program = glCreateProgram();
+        programs[captured] = program;
+        std::vector<GLuint> shaders;
+        for (uint32_t i = 0; i < numShaders && valid; ++i)
+        {
+            GLenum type = get<GLenum>();
+            std::string source = getString();
+            const char* code = source.c_str();
+            GLuint shader = glCreateShader(type);
+            glShaderSource(shader, 1, &code, nullptr);
+            glCompileShader(shader);
+            GLint success;
+            glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+            if (!success)
+            {
+                GLchar infoLog[1024];
+                glGetShaderInfoLog(shader, 1024, nullptr, infoLog);
+                std::cerr << "ERROR::GLREPLAY: Shader compilation failed\n" << infoLog << std::endl;
+            }
+            glAttachShader(program, shader);
+            shaders.push_back(shader);
+        }
+        glLinkProgram(program);
+        for (GLuint shader : shaders)
+            glDeleteShader(shader);
+        GLint success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            GLchar infoLog[1024];
+            glGetProgramInfoLog(program, 1024, nullptr, infoLog);
+            std::cerr << "ERROR::GLREPLAY: Program linking failed\n" << infoLog << std::endl;
+        }
+
+        // Restore the values set before the captured frame and map locations by name
+        glUseProgram(program);
+        auto& locations = uniformLocations[captured];
+        uint32_t numUniforms = get<uint32_t>();
+        for (uint32_t i = 0; i < numUniforms && valid; ++i)
+        {
+            std::string name = getString();
+            GLint capturedLocation = get<GLint>();
+            GLUniformType type = get<GLUniformType>();
+            uint32_t size;
+            const uint8_t* data = getBlob(size);
+            GLint location = glGetUniformLocation(program, name.c_str());
+            locations[capturedLocation] = location;
+            if (data)
+                setUniform(location, type, 1, data);
+        }
+        glUseProgram(0);
+    }
+
+    void createFramebuffer()
+    {
+        GLuint captured = get<GLuint>();
+        uint32_t numAttachments = get<uint32_t>();
+
+        GLuint& framebuffer = framebuffers[captured];
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        for (uint32_t i = 0; i < numAttachments && valid; ++i)
+        {
+            GLCaptureAttachment attachment = get<GLCaptureAttachment>();
+            if (attachment.type == GL_TEXTURE)
+            {
+                glFramebufferTexture2D(GL_FRAMEBUFFER, attachment.point, GL_TEXTURE_2D,
+                    remap(textures, static_cast<GLuint>(attachment.name)), 0);
+            }
+            else if (attachment.type == GL_RENDERBUFFER)
+            {
+                GLuint renderbuffer;
+                glGenRenderbuffers(1, &renderbuffer);
+                glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+                glRenderbufferStorageMultisample(GL_RENDERBUFFER, attachment.samples, attachment.format, attachment.width, attachment.height);
+                glBindRenderbuffer(GL_RENDERBUFFER, 0);
+                glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment.point, GL_RENDERBUFFER, renderbuffer);
+                renderbuffers.push_back(renderbuffer);
+            }
+        }
+
+        uint32_t numDrawBuffers = get<uint32_t>();
+        std::vector<GLenum> drawBuffers;
+        for (uint32_t i = 0; i < numDrawBuffers && valid; ++i)
+            drawBuffers.push_back(static_cast<GLenum>(get<GLint>()));
+        bool hasColor = std::any_of(drawBuffers.begin(), drawBuffers.end(), [](GLenum buffer) { return buffer != GL_NONE; });
+        glDrawBuffers(static_cast<GLsizei>(drawBuffers.size()), drawBuffers.data());
+        glReadBuffer(hasColor ? drawBuffers[0] : GL_NONE);
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cerr << "ERROR::GLREPLAY: Framebuffer " << captured << " is not complete" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    void decodeFrame(size_t end)
+    {
+        GLuint currentProgram = 0;
+        while (cursor < end && valid)
+        {
+            Op op = { get<GLCommand>(), {}, 0, nullptr };
+            switch (op.command)
+            {
+            case GLCommand::Enable:
+            case GLCommand::Disable:
+            case GLCommand::Clear:
+            case GLCommand::CullFace:
+            case GLCommand::DepthFunc:
+                op.args[0] = get<GLuint>();
+                break;
+            case GLCommand::BlendFunc:
+                op.args[0] = get<GLenum>();
+                op.args[1] = get<GLenum>();
+                break;
+            case GLCommand::Viewport:
+            case GLCommand::ClearColor:
+                for (GLuint& arg : op.args)
+                    arg = get<GLuint>(); // Floats for ClearColor, copied back bitwise
+                break;
+            case GLCommand::UseProgram:
+                currentProgram = get<GLuint>();
+                op.args[0] = remap(programs, currentProgram);
+                break;
+            case GLCommand::BindVertexArray:
+                op.args[0] = remap(vertexArrays, get<GLuint>());
+                break;
+            case GLCommand::BindTexture:
+                op.args[0] = get<GLuint>();
+                op.args[1] = get<GLenum>();
+                op.args[2] = remap(textures, get<GLuint>());
+                break;
+            case GLCommand::BindSampler:
+                op.args[0] = get<GLuint>();
+                op.args[1] = remap(samplers, get<GLuint>());
+                break;
+            case GLCommand::BindBuffer:
+                op.args[0] = get<GLenum>();
+                op.args[1] = remap(buffers, get<GLuint>());
+                break;
+            case GLCommand::BindFramebuffer:
+                op.args[0] = remap(framebuffers, get<GLuint>());
+                break;
+            case GLCommand::DrawBuffers:
+            {
+                uint32_t size;
+                op.data = getBlob(size);
+                op.args[0] = size / sizeof(GLenum);
+                break;
+            }
+            case GLCommand::BlitFramebuffer:
+            {
+                op.args[0] = remap(framebuffers, get<GLuint>());
+                op.args[1] = get<GLbitfield>();
+                op.args[2] = get<GLenum>();
+                uint32_t size;
+                op.data = getBlob(size);
+                if (size != sizeof(GLint) * 8)
+                    valid = false;
+                break;
+            }
+            case GLCommand::BufferSubData:
+            {
+                op.args[0] = get<GLenum>();
+                op.offset = get<uint64_t>();
+                uint32_t size;
+                op.data = getBlob(size);
+                op.args[1] = size;
+                break;
+            }
+            case GLCommand::Uniform:
+            {
+                GLint location = get<GLint>();
+                const auto& locations = uniformLocations[currentProgram];
+                auto it = locations.find(location);
+                op.args[0] = static_cast<GLuint>(it != locations.end() ? it->second : -1);
+                op.args[1] = static_cast<GLuint>(get<GLUniformType>());
+                op.args[2] = static_cast<GLuint>(get<GLsizei>());
+                uint32_t size;
+                op.data = getBlob(size);
+                break;
+            }
+            case GLCommand::DrawElements:
+                op.args[0] = get<GLenum>();
+                op.args[1] = static_cast<GLuint>(get<GLsizei>());
+                op.args[2] = get<GLenum>();
+                op.offset = get<uint64_t>();
+                break;
+            case GLCommand::DrawArrays:
+                op.args[0] = get<GLenum>();
+                op.args[1] = static_cast<GLuint>(get<GLint>());
+                op.args[2] = static_cast<GLuint>(get<GLsizei>());
+                break;
+            case GLCommand::DrawElementsInstanced:
+                op.args[0] = get<GLenum>();
+                op.args[1] = static_cast<GLuint>(get<GLsizei>());
+                op.args[2] = get<GLenum>();
+                op.offset = get<uint64_t>();
+                op.args[3] = static_cast<GLuint>(get<GLsizei>());
+                break;
+            default:
+                std::cerr << "ERROR::GLREPLAY: Unexpected command in frame" << std::endl;
+                valid = false;
+                continue;
+            }
+            ops.push_back(op);
+        }
+    }
+
+    static void setUniform(GLint location, GLUniformType type, GLsizei count, const void* data)
+    {
+        const GLfloat* values = static_cast<const GLfloat*>(data);
+        switch (type)
+        {
+        case GLUniformType::Int:   glUniform1iv(location, count, static_cast<const GLint*>(data)); break;
+        case GLUniformType::Float: glUniform1fv(location, count, values); break;
+        case GLUniformType::Vec2:  glUniform2fv(location, count, values); break;
+        case GLUniformType::Vec3:  glUniform3fv(location, count, values); break;
+        case GLUniformType::Vec4:  glUniform4fv(location, count, values); break;
+        case GLUniformType::Mat2:  glUniformMatrix2fv(location, count, GL_FALSE, values); break;
+        case GLUniformType::Mat3:  glUniformMatrix3fv(location, count, GL_FALSE, values); break;
+        case GLUniformType::Mat4:  glUniformMatrix4fv(location, count, GL_FALSE, values); break;
+        }
+    }
+
+    static GLfloat asFloat(GLuint bits)
+    {
+        GLfloat value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    void execute() const
+    {
+        for (const Op& op : ops)
+        {
+            const GLuint* args = op.args;
+            switch (op.command)
+            {
+            case GLCommand::Enable:          glEnable(args[0]); break;
+            case GLCommand::Disable:         glDisable(args[0]); break;
+            case GLCommand::Viewport:        glViewport(static_cast<GLint>(args[0]), static_cast<GLint>(args[1]), args[2], args[3]); break;
+            case GLCommand::ClearColor:      glClearColor(asFloat(args[0]), asFloat(args[1]), asFloat(args[2]), asFloat(args[3])); break;
+            case GLCommand::Clear:           glClear(args[0]); break;
+            case GLCommand::CullFace:        glCullFace(args[0]); break;
+            case GLCommand::DepthFunc:       glDepthFunc(args[0]); break;
+            case GLCommand::BlendFunc:       glBlendFunc(args[0], args[1]); break;
+            case GLCommand::UseProgram:      glUseProgram(args[0]); break;
+            case GLCommand::BindVertexArray: glBindVertexArray(args[0]); break;
+            case GLCommand::BindTexture:
+                glActiveTexture(GL_TEXTURE0 + args[0]);
+                glBindTexture(args[1], args[2]);
+                break;
+            case GLCommand::BindSampler:     glBindSampler(args[0], args[1]); break;
+            case GLCommand::BindBuffer:      glBindBuffer(args[0], args[1]); break;
+            case GLCommand::BindFramebuffer: glBindFramebuffer(GL_FRAMEBUFFER, args[0]); break;
+            case GLCommand::DrawBuffers:
+                glDrawBuffers(static_cast<GLsizei>(args[0]), static_cast<const GLenum*>(op.data));
+                break;
+            case GLCommand::BlitFramebuffer:
+            {
+                const GLint* rectangles = static_cast<const GLint*>(op.data);
+                glBindFramebuffer(GL_READ_FRAMEBUFFER, args[0]);
+                glBlitFramebuffer(rectangles[0], rectangles[1], rectangles[2], rectangles[3],
+                    rectangles[4], rectangles[5], rectangles[6], rectangles[7], args[1], args[2]);
+                break;
+            }
+            case GLCommand::BufferSubData:
+                glBufferSubData(args[0], static_cast<GLintptr>(op.offset), args[1], op.data);
+                break;
+            case GLCommand::Uniform:
+                setUniform(static_cast<GLint>(args[0]), static_cast<GLUniformType>(args[1]), static_cast<GLsizei>(args[2]), op.data);
+                break;
+            case GLCommand::DrawElements:
+                glDrawElements(args[0], static_cast<GLsizei>(args[1]), args[2], reinterpret_cast<const void*>(static_cast<uintptr_t>(op.offset)));
+                break;
+            case GLCommand::DrawArrays:
+                glDrawArrays(args[0], static_cast<GLint>(args[1]), static_cast<GLsizei>(args[2]));
+                break;
+            case GLCommand::DrawElementsInstanced:
+                glDrawElementsInstanced(args[0], static_cast<GLsizei>(args[1]), args[2],
+                    reinterpret_cast<const void*>(static_cast<uintptr_t>(op.offset)), static_cast<GLsizei>(args[3]));
+                break;
+            default:
+                break;
+            }
+        }
+    }
+};
@@ -0,0 +1,304 @@
+#pragma once
+
+#include "gl_recorder.hpp"
+
+#include <glad/gl.h>
+
+#include <array>
+
+// Shadow copy of the GL binding state. All program, VAO, texture, sampler, buffer and framebuffer
+// binds go through here so redundant ones are skipped; the counters quantify the saved driver calls.
+// Frame commands (viewport, clears, draws) go through here too, so GLRecorder sees the whole frame.
+class GLState
+{
+public:
+    static constexpr GLuint MAX_TEXTURE_UNITS = 16;
+
+    struct Stats
+    {
+        unsigned int Issued = 0;
+        unsigned int Skipped = 0;
+        unsigned int TextureBinds = 0;
+        unsigned int ProgramBinds = 0;
+        unsigned int DrawCalls = 0;
+    };
+
+    static GLState& GetInstance()
+    {
+        static GLState instance;
+        return instance;
+    }
+
+    void UseProgram(GLuint program)
+    {
+        if (!changed(currentProgram, program))
+            return;
+        glUseProgram(program);
+        stats.ProgramBinds++;
+        if (recorder.IsRecording())
+            recorder.UseProgram(program);
+    }
+
+    void BindVertexArray(GLuint vao)
+    {
+        if (!changed(currentVAO, vao))
+            return;
+        glBindVertexArray(vao);
+        // The element buffer binding is part of the VAO
+        currentBuffers[bufferIndex(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+        if (recorder.IsRecording())
+            recorder.BindVertexArray(vao);
+    }
+
+    void ActiveTexture(GLuint unit)
+    {
+        if (!changed(activeUnit, unit))
+            return;
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+
+    void BindTexture(GLuint unit, GLenum target, GLuint texture)
+    {
+        int index = textureIndex(target);
+        if (unit < MAX_TEXTURE_UNITS && index >= 0 && currentTextures[unit][index] == texture)
+        {
+            stats.Skipped++;
+            return;
+        }
+        ActiveTexture(unit);
+        glBindTexture(target, texture);
+        if (unit < MAX_TEXTURE_UNITS && index >= 0)
+            currentTextures[unit][index] = texture;
+        stats.Issued++;
+        stats.TextureBinds++;
+        if (recorder.IsRecording())
+            recorder.BindTexture(unit, target, texture);
+    }
+
+    // Bind on whichever unit is active, for uploads that do not care about the unit
+    void BindTexture(GLenum target, GLuint texture)
+    {
+        BindTexture(activeUnit == UNKNOWN ? 0 : activeUnit, target, texture);
+    }
+
+    // Sampler 0 restores the texture's own parameters, e.g. for the shadow map
+    void BindSampler(GLuint unit, GLuint sampler)
+    {
+        if (unit < MAX_TEXTURE_UNITS && !changed(currentSamplers[unit], sampler))
+            return;
+        if (unit >= MAX_TEXTURE_UNITS)
+            stats.Issued++;
+        glBindSampler(unit, sampler);
+        if (recorder.IsRecording())
+            recorder.BindSampler(unit, sampler);
+    }
+
+    void BindBuffer(GLenum target, GLuint buffer)
+    {
+        int index = bufferIndex(target);
+        if (index >= 0 && !changed(currentBuffers[index], buffer))
+            return;
+        if (index < 0)
+            stats.Issued++;
+        glBindBuffer(target, buffer);
+        if (recorder.IsRecording())
+            recorder.BindBuffer(target, buffer);
+    }
+
+    // Deleting unbinds the object, so it is forgotten wherever it is cached; a new object may reuse the name
+    void DeleteBuffer(GLuint buffer)
+    {
+        for (auto& current : currentBuffers)
+            if (current == buffer)
+                current = 0;
+        glDeleteBuffers(1, &buffer);
+    }
+
+    void DeleteVertexArray(GLuint vao)
+    {
+        if (currentVAO == vao)
+        {
+            currentVAO = 0;
+            currentBuffers[bufferIndex(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+        }
+        glDeleteVertexArrays(1, &vao);
+    }
+
+    // Binds it for both drawing and reading
+    void BindFramebuffer(GLuint framebuffer)
+    {
+        if (currentFramebuffer == framebuffer && currentReadFramebuffer == framebuffer)
+        {
+            stats.Skipped++;
+            return;
+        }
+        currentFramebuffer = currentReadFramebuffer = framebuffer;
+        stats.Issued++;
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        if (recorder.IsRecording())
+            recorder.BindFramebuffer(framebuffer);
+    }
+
+    // Sets the color attachments fragment outputs go to, on the bound framebuffer
+    void DrawBuffers(GLsizei count, const GLenum* buffers)
+    {
+        glDrawBuffers(count, buffers);
+        stats.Issued++;
+        if (recorder.IsRecording())
+            recorder.DrawBuffers(count, buffers);
+    }
+
+    // Copies a rectangle of source into the bound draw framebuffer; source stays bound for reading
+    void BlitFramebuffer(GLuint source, GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1,
+        GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter)
+    {
+        if (changed(currentReadFramebuffer, source))
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, source);
+        glBlitFramebuffer(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+        stats.Issued++;
+        if (recorder.IsRecording())
+            recorder.BlitFramebuffer(source, { srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1 }, mask, filter);
+    }
+
+    void SetEnabled(GLenum capability, bool enabled)
+    {
+        enabled ? glEnable(capability) : glDisable(capability);
+        if (recorder.IsRecording())
+            recorder.Enable(capability, enabled);
+    }
+
+    void Viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+    {
+        glViewport(x, y, width, height);
+        if (recorder.IsRecording())
+            recorder.Viewport(x, y, width, height);
+    }
+
+    void CullFace(GLenum mode)
+    {
+        if (!changed(currentCullFace, mode))
+            return;
+        glCullFace(mode);
+        if (recorder.IsRecording())
+            recorder.CullFace(mode);
+    }
+
+    void ClearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a)
+    {
+        glClearColor(r, g, b, a);
+        if (recorder.IsRecording())
+            recorder.ClearColor(r, g, b, a);
+    }
+
+    void Clear(GLbitfield mask)
+    {
+        glClear(mask);
+        if (recorder.IsRecording())
+            recorder.Clear(mask);
+    }
+
+    // Per-frame uploads into the bound buffer
+    void BufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+    {
+        glBufferSubData(target, offset, size, data);
+        if (recorder.IsRecording())
+            recorder.BufferSubData(target, offset, size, data);
+    }
+
+    void DrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+    {
+        glDrawElements(mode, count, type, indices);
+        stats.DrawCalls++;
+        if (recorder.IsRecording())
+            recorder.DrawElements(mode, count, type, indices);
+    }
+
+    void DrawArrays(GLenum mode, GLint first, GLsizei count)
+    {
+        glDrawArrays(mode, first, count);
+        stats.DrawCalls++;
+        if (recorder.IsRecording())
+            recorder.DrawArrays(mode, first, count);
+    }
+
+    void DrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instances)
+    {
+        glDrawElementsInstanced(mode, count, type, indices, instances);
+        stats.DrawCalls++;
+        if (recorder.IsRecording())
+            recorder.DrawElementsInstanced(mode, count, type, indices, instances);
+    }
+
+    // Forget everything, for when GL state was changed by code that does not go through here
+    void Invalidate()
+    {
+        currentProgram = currentVAO = activeUnit = currentFramebuffer = currentReadFramebuffer = currentCullFace = UNKNOWN;
+        for (auto& unit : currentTextures)
+            unit.fill(UNKNOWN);
+        currentSamplers.fill(UNKNOWN);
+        currentBuffers.fill(UNKNOWN);
+    }
+
+    // Uniform caches in Shader report through here too
+    void CountCall(bool issued) { issued ? stats.Issued++ : stats.Skipped++; }
+
+    // Returns the counters of the frame that just ended and starts a new one
+    Stats EndFrame()
+    {
+        Stats frame = stats;
+        stats = Stats();
+        return frame;
+    }
+
+private:
+    static constexpr GLuint UNKNOWN = ~0u;
+    static constexpr int NUM_TEXTURE_TARGETS = 3;
+    static constexpr int NUM_BUFFER_TARGETS = 4;
+
+    GLuint currentProgram, currentVAO, activeUnit, currentFramebuffer, currentReadFramebuffer, currentCullFace;
+    std::array<std::array<GLuint, NUM_TEXTURE_TARGETS>, MAX_TEXTURE_UNITS> currentTextures;
+    std::array<GLuint, MAX_TEXTURE_UNITS> currentSamplers;
+    std::array<GLuint, NUM_BUFFER_TARGETS> currentBuffers;
+    Stats stats;
+    GLRecorder& recorder = GLRecorder::GetInstance();
+
+    GLState() { Invalidate(); }
+    GLState(const GLState&) = delete;
+    GLState& operator=(const GLState&) = delete;
+
+    // Updates the shadow value and counts the call as issued or skipped
+    bool changed(GLuint& current, GLuint value)
+    {
+        if (current == value)
+        {
+            stats.Skipped++;
+            return false;
+        }
+        current = value;
+        stats.Issued++;
+        return true;
+    }
+
+    static int textureIndex(GLenum target)
+    {
+        switch (target)
+        {
+        case GL_TEXTURE_2D:       return 0;
+        case GL_TEXTURE_2D_ARRAY: return 1;
+        case GL_TEXTURE_BUFFER:   return 2;
+        default:                  return -1;
+        }
+    }
+
+    static int bufferIndex(GLenum target)
+    {
+        switch (target)
+        {
+        case GL_ARRAY_BUFFER:         return 0;
+        case GL_ELEMENT_ARRAY_BUFFER: return 1;
+        case GL_UNIFORM_BUFFER:       return 2;
+        case GL_TEXTURE_BUFFER:       return 3;
+        default:                      return -1;
+        }
+    }
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "animation_texture.hpp"
+#include "basic_model.hpp"
+#include "gl_state.hpp"
+#include "gpu_memory.hpp"
+#include "shader.hpp"
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Agents of a background crowd, drawn with one instanced draw per mesh and animated entirely in
+// crowd.vs from an AnimationTexture. Agents never change after Build, the only per-frame input is the
+// crowd's time, so the CPU cost does not grow with the number of agents. Agents sharing a clip and rate
+// form a track whose time is wrapped to the clip on the CPU in double, so it never loses float precision.
+class GpuCrowd
+{
+public:
+    static constexpr int INSTANCES_PER_ROW = 512; // Matches crowd.vs
+    static constexpr size_t MAX_TRACKS = 32; // Matches crowd.vs
+
+    struct Agent
+    {
+        glm::vec3 position;
+        float yaw;         // Radians around the Y axis
+        unsigned int clip; // Index into the animation texture
+        float startTime;   // Crowd time at which the clip was at its start, spreads agents over the clip
+        float rate;        // Playback speed
+    };
+
+    // Uploads the agents into an RGBA32F texture, two texels per agent: position and yaw, then clip,
+    // start time, rate and track
+    void Build(const std::vector<Agent>& agents)
+    {
+        tracks.clear();
+        numAgents = static_cast<GLsizei>(agents.size());
+        if (numAgents == 0)
+            return;
+        const GLsizei width = std::min(numAgents, static_cast<GLsizei>(INSTANCES_PER_ROW)) * 2;
+        const GLsizei height = (numAgents + INSTANCES_PER_ROW - 1) / INSTANCES_PER_ROW;
+        std::vector<glm::vec4> texels(static_cast<size_t>(width) * height, glm::vec4(0.0f));
+        bool tracksFull = false;
+        for (GLsizei i = 0; i < numAgents; ++i)
+        {
+            const Agent& agent = agents[i];
+            size_t track = findTrack(agent);
+            if (track == MAX_TRACKS)
+            {
+                tracksFull = true;
+                track = MAX_TRACKS - 1; // Plays, but out of phase
+            }
+            size_t texel = static_cast<size_t>(i / INSTANCES_PER_ROW) * width + (i % INSTANCES_PER_ROW) * 2;
+            texels[texel] = glm::vec4(agent.position, agent.yaw);
+            texels[texel + 1] = glm::vec4(static_cast<float>(agent.clip), agent.startTime, agent.rate, static_cast<float>(track));
+        }
+        if (tracksFull)
+            std::cerr << "ERROR::GPUCROWD: More than " << MAX_TRACKS << " clip and rate pairs, some agents are out of phase" << std::endl;
+
+        if (ID == 0)
+            glGenTextures(1, &ID);
+        GLState::GetInstance().BindTexture(GL_TEXTURE_2D, ID);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, texels.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        GpuMemory::GetInstance().TrackTexture(ID, texels.size() * sizeof(glm::vec4), GpuMemoryCategory::Texture, "crowd agents");
+    }
+
+    // The shader must be a crowd.vs program with its view, projection and lighting uniforms set
+    void Draw(const Shader& shader, const BasicModel& model, const AnimationTexture& animations, double time) const
+    {
+        if (numAgents == 0)
+            return;
+        animations.Bind(shader, ANIMATION_UNIT);
+        shader.SetInt("crowdInstances", static_cast<int>(AGENT_UNIT));
+        // (time - start) * rate wrapped to the clip equals time * rate wrapped, minus start * rate, wrapped again
+        for (size_t i = 0; i < tracks.size(); ++i)
+        {
+            double duration = tracks[i].clip < animations.GetNumClips() ? animations.GetDuration(tracks[i].clip) : 0.0;
+            double trackTime = duration > 0.0 ? std::fmod(time * tracks[i].rate, duration) : 0.0;
+            shader.SetFloat("trackTimes[" + std::to_string(i) + "]", static_cast<float>(trackTime));
+        }
+        GLState& glState = GLState::GetInstance();
+        glState.BindTexture(AGENT_UNIT, GL_TEXTURE_2D, ID);
+        glState.BindSampler(AGENT_UNIT, 0);
+        model.DrawInstanced(shader, numAgents);
+    }
+
+    GLsizei GetNumAgents() const { return numAgents; }
+
+private:
+    // Units 0-4 are taken by materials and the shadow map
+    static constexpr GLuint ANIMATION_UNIT = 5;
+    static constexpr GLuint AGENT_UNIT = 6;
+
+    struct Track
+    {
+        unsigned int clip;
+        float rate;
+    };
+
+    GLuint ID = 0;
+    GLsizei numAgents = 0;
+    std::vector<Track> tracks;
+
+    // Returns MAX_TRACKS when all tracks are taken by other clip and rate pairs
+    size_t findTrack(const Agent& agent)
+    {
+        for (size_t i = 0; i < tracks.size(); ++i)
+            if (tracks[i].clip == agent.clip && tracks[i].rate == agent.rate)
+                return i;
+        if (tracks.size() == MAX_TRACKS)
+            return MAX_TRACKS;
+        tracks.push_back({ agent.clip, agent.rate });
+        return tracks.size() - 1;
+    }
+};
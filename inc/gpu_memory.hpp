@@ -0,0 +1,153 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+enum class GpuMemoryCategory
+{
+    Vertex,
+    Index,
+    Texture,
+    RenderTarget,
+    Uniform,
+    Count
+};
+
+// Registry of GPU allocations, fed by every site that sizes a buffer or texture. Allocations are keyed by
+// their GL name, so respecifying an object (e.g. streaming in more mips) replaces its previous size.
+class GpuMemory
+{
+public:
+    static GpuMemory& GetInstance()
+    {
+        static GpuMemory instance;
+        return instance;
+    }
+
+    void TrackBuffer(GLuint buffer, size_t bytes, GpuMemoryCategory category, const std::string& asset)
+    {
+        track(buffers, buffer, bytes, category, asset);
+    }
+
+    void TrackTexture(GLuint texture, size_t bytes, GpuMemoryCategory category, const std::string& asset)
+    {
+        track(textures, texture, bytes, category, asset);
+    }
+
+    void ReleaseBuffer(GLuint buffer) { release(buffers, buffer); }
+    void ReleaseTexture(GLuint texture) { release(textures, texture); }
+
+    size_t GetBytes(GpuMemoryCategory category) const { return categoryBytes[static_cast<size_t>(category)]; }
+
+    size_t GetTotalBytes() const
+    {
+        size_t total = 0;
+        for (size_t bytes : categoryBytes)
+            total += bytes;
+        return total;
+    }
+
+    size_t GetAssetBytes(const std::string& asset) const
+    {
+        auto it = assetBytes.find(asset);
+        return it != assetBytes.end() ? it->second : 0;
+    }
+
+    // Assets sorted by size, largest first
+    std::vector<std::pair<std::string, size_t>> GetAssets() const
+    {
+        std::vector<std::pair<std::string, size_t>> assets(assetBytes.begin(), assetBytes.end());
+        std::sort(assets.begin(), assets.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+        return assets;
+    }
+
+    // Estimated bytes per texel; drivers pad 3-component formats to 4
+    static size_t BytesPerPixel(GLenum internalFormat)
+    {
+        switch (internalFormat)
+        {
+        case GL_RED:
+        case GL_R8:             return 1;
+        case GL_RG:
+        case GL_RG8:
+        case GL_DEPTH_COMPONENT16: return 2;
+        case GL_RGBA16F:        return 8;
+        case GL_RGBA32F:        return 16;
+        default:                return 4;
+        }
+    }
+
+    static const char* CategoryName(GpuMemoryCategory category)
+    {
+        switch (category)
+        {
+        case GpuMemoryCategory::Vertex:       return "vertex";
+        case GpuMemoryCategory::Index:        return "index";
+        case GpuMemoryCategory::Texture:      return "texture";
+        case GpuMemoryCategory::RenderTarget: return "render target";
+        case GpuMemoryCategory::Uniform:      return "uniform";
+        default:                              return "unknown";
+        }
+    }
+
+    // One line with the total and the per-category split, plus the largest assets
+    void Log(size_t topAssets = 3) const
+    {
+        std::cout << std::fixed << std::setprecision(2) << "GPU memory: " << toMB(GetTotalBytes()) << " MB (";
+        for (size_t i = 0; i < categoryBytes.size(); ++i)
+            std::cout << (i > 0 ? ", " : "") << CategoryName(static_cast<GpuMemoryCategory>(i)) << " " << toMB(categoryBytes[i]);
+        std::cout << ")";
+        auto assets = GetAssets();
+        for (size_t i = 0; i < topAssets && i < assets.size(); ++i)
+            std::cout << (i == 0 ? " - largest: " : ", ") << assets[i].first << " " << toMB(assets[i].second);
+        std::cout << std::defaultfloat << std::endl;
+    }
+
+private:
+    struct Allocation
+    {
+        size_t bytes;
+        GpuMemoryCategory category;
+        std::string asset;
+    };
+
+    std::map<GLuint, Allocation> buffers;
+    std::map<GLuint, Allocation> textures;
+    std::array<size_t, static_cast<size_t>(GpuMemoryCategory::Count)> categoryBytes{};
+    std::map<std::string, size_t> assetBytes;
+
+    GpuMemory() {}
+    GpuMemory(const GpuMemory&) = delete;
+    GpuMemory& operator=(const GpuMemory&) = delete;
+
+    static double toMB(size_t bytes) { return bytes / (1024.0 * 1024.0); }
+
+    void track(std::map<GLuint, Allocation>& allocations, GLuint name, size_t bytes, GpuMemoryCategory category, const std::string& asset)
+    {
+        release(allocations, name);
+        allocations[name] = { bytes, category, asset };
+        categoryBytes[static_cast<size_t>(category)] += bytes;
+        assetBytes[asset] += bytes;
+    }
+
+    void release(std::map<GLuint, Allocation>& allocations, GLuint name)
+    {
+        auto it = allocations.find(name);
+        if (it == allocations.end())
+            return;
+        categoryBytes[static_cast<size_t>(it->second.category)] -= it->second.bytes;
+        auto asset = assetBytes.find(it->second.asset);
+        if ((asset->second -= it->second.bytes) == 0)
+            assetBytes.erase(asset);
+        allocations.erase(it);
+    }
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <glad/gl.h>
+
+#include <array>
+#include <vector>
+
+// GPU time of a span of commands, from GL_TIME_ELAPSED queries kept in a small ring so results are read
+// a few frames late instead of stalling on the frame just submitted
+class GpuTimer
+{
+public:
+    static constexpr int LATENCY = 4; // Spans in flight before Begin has to wait for the oldest
+
+    ~GpuTimer()
+    {
+        if (queries[0] != 0)
+            glDeleteQueries(LATENCY, queries.data());
+    }
+
+    GpuTimer() = default;
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    void Begin()
+    {
+        if (queries[0] == 0)
+            glGenQueries(LATENCY, queries.data());
+        if (pending[next])
+            read(next);
+        glBeginQuery(GL_TIME_ELAPSED, queries[next]);
+    }
+
+    void End()
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+        pending[next] = true;
+        next = (next + 1) % LATENCY;
+    }
+
+    // Appends the milliseconds of the spans finished since the last call, oldest first, to a list the
+    // caller keeps across frames; wait blocks until all are
+    void Collect(std::vector<float>& milliseconds, bool wait = false)
+    {
+        for (int i = 0; i < LATENCY; ++i)
+        {
+            int query = (next + i) % LATENCY;
+            if (!pending[query])
+                continue;
+            GLint available = GL_FALSE;
+            if (!wait)
+                glGetQueryObjectiv(queries[query], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!wait && !available)
+                break; // Later spans cannot have finished before this one
+            read(query);
+        }
+        milliseconds.insert(milliseconds.end(), results.begin(), results.end());
+        results.clear();
+    }
+
+private:
+    std::array<GLuint, LATENCY> queries{};
+    std::array<bool, LATENCY> pending{};
+    int next = 0;
+    std::vector<float> results; // Read by Begin when the ring is full, until the next Collect
+
+    void read(int query)
+    {
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(queries[query], GL_QUERY_RESULT, &nanoseconds);
+        results.push_back(static_cast<float>(nanoseconds) * 1e-6f);
+        pending[query] = false;
+    }
+};
@@ -0,0 +1,285 @@
+#pragma once
+
+#include "material.hpp"
+#include "mesh.hpp"
+#include "shader.hpp"
+#include "texture_array.hpp"
+#include "thread_pool.hpp"
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// An unbounded ground split into square chunks, built on worker threads around a center (the camera) and
+// released once it moves away. Far chunks use coarser grids; every chunk keeps world-space bounds so draws
+// are culled per chunk against the camera or light frustum.
+class GroundChunks
+{
+public:
+    struct Config
+    {
+        float ChunkSize = 16.0f;
+        int LoadRadius = 4; // Chunks kept around the center in each direction
+        int MaxLod = 3; // LOD n has RESOLUTION >> n quads per side
+        float LodDistance = 32.0f; // Distance from the center covered by each LOD
+        int MaxBuildsPerFrame = 4;
+        std::function<float(float, float)> Height; // Ground height at (x, z), called on worker threads; flat when empty
+    };
+
+    struct Stats
+    {
+        unsigned int Resident = 0;
+        unsigned int Pending = 0;
+        unsigned int Drawn = 0;
+        unsigned int Culled = 0;
+    };
+
+    static constexpr int RESOLUTION = 32;
+
+    GroundChunks(ThreadPool& pool, const std::string& texturePath, Config config = {})
+        : pool(pool), config(std::move(config))
+    {
+        std::vector<Texture> textures = {
+            { TextureArrayPool::GetInstance().Load(texturePath, { .wrapS = GL_REPEAT, .wrapT = GL_REPEAT }), TextureSlot::Diffuse, texturePath }
+        };
+        material = std::make_shared<Material>(textures);
+    }
+
+    ~GroundChunks()
+    {
+        for (auto& [key, chunk] : chunks)
+        {
+            if (chunk.pending.valid())
+                chunk.pending.wait();
+            if (chunk.mesh)
+                chunk.mesh->Release();
+        }
+    }
+
+    GroundChunks(const GroundChunks&) = delete;
+    GroundChunks& operator=(const GroundChunks&) = delete;
+
+    // Upload finished chunks, release far ones and schedule missing or re-LODed ones, nearest first. Call once per frame on the GL thread.
+    void Update(const glm::vec3& center)
+    {
+        const int centerX = static_cast<int>(std::floor(center.x / config.ChunkSize));
+        const int centerZ = static_cast<int>(std::floor(center.z / config.ChunkSize));
+
+        stats.Pending = 0;
+        for (auto it = chunks.begin(); it != chunks.end();)
+        {
+            Chunk& chunk = it->second;
+            if (chunk.pending.valid())
+            {
+                if (chunk.pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                {
+                    stats.Pending++;
+                    ++it;
+                    continue;
+                }
+                finishBuild(chunk);
+            }
+
+            // One chunk of slack, so walking along a chunk border does not reload it every step
+            if (std::abs(chunk.x - centerX) > config.LoadRadius + 1 || std::abs(chunk.z - centerZ) > config.LoadRadius + 1)
+            {
+                if (chunk.mesh)
+                    chunk.mesh->Release();
+                it = chunks.erase(it);
+            }
+            else
+                ++it;
+        }
+
+        struct Candidate
+        {
+            int x, z, lod;
+            float distance;
+        };
+        std::vector<Candidate> candidates;
+        for (int z = centerZ - config.LoadRadius; z <= centerZ + config.LoadRadius; ++z)
+            for (int x = centerX - config.LoadRadius; x <= centerX + config.LoadRadius; ++x)
+            {
+                glm::vec2 chunkCenter = (glm::vec2(x, z) + 0.5f) * config.ChunkSize;
+                float distance = glm::length(chunkCenter - glm::vec2(center.x, center.z));
+                int lod = std::min(config.MaxLod, static_cast<int>(distance / config.LodDistance));
+                auto it = chunks.find(key(x, z));
+                if (it != chunks.end() && (it->second.pending.valid() || keepsLod(it->second.lod, distance)))
+                    continue;
+                candidates.push_back({ x, z, lod, distance });
+            }
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.distance < b.distance; });
+
+        int builds = 0;
+        for (const Candidate& candidate : candidates)
+        {
+            if (builds++ >= config.MaxBuildsPerFrame)
+                break;
+            Chunk& chunk = chunks[key(candidate.x, candidate.z)];
+            chunk.x = candidate.x;
+            chunk.z = candidate.z;
+            startBuild(chunk, candidate.lod);
+            stats.Pending++;
+        }
+        stats.Resident = 0;
+        for (const auto& [chunkKey, chunk] : chunks)
+            if (chunk.mesh)
+                stats.Resident++;
+    }
+
+    // Draws the resident chunks whose bounds intersect the frustum of viewProj
+    void Draw(const Shader& shader, const glm::mat4& viewProj)
+    {
+        std::array<glm::vec4, 6> planes = frustumPlanes(viewProj);
+        shader.Use();
+        shader.SetBool("animated", false);
+        shader.SetMat4("modelMatrix", glm::mat4(1.0f));
+        shader.SetMat3("normalMatrix", glm::mat3(1.0f));
+        stats.Drawn = stats.Culled = 0;
+        for (const auto& [chunkKey, chunk] : chunks)
+        {
+            if (!chunk.mesh)
+                continue;
+            if (!intersects(planes, chunk.min, chunk.max))
+            {
+                stats.Culled++;
+                continue;
+            }
+            chunk.mesh->Draw(shader);
+            stats.Drawn++;
+        }
+    }
+
+    const Stats& GetStats() const { return stats; }
+
+private:
+    // A resident LOD is kept until the distance leaves its band by LOD_HYSTERESIS of LodDistance, so a
+    // camera moving along a boundary does not rebuild the chunk back and forth
+    static constexpr float LOD_HYSTERESIS = 0.1f;
+
+    struct Geometry
+    {
+        std::vector<Vertex> vertices;
+        std::vector<GLuint> indices;
+        glm::vec3 min, max;
+    };
+
+    struct Chunk
+    {
+        int x = 0, z = 0;
+        int lod = -1; // Of the resident mesh, -1 while none is
+        int pendingLod = -1;
+        glm::vec3 min{ 0.0f }, max{ 0.0f };
+        std::unique_ptr<Mesh> mesh;
+        std::future<Geometry> pending;
+    };
+
+    ThreadPool& pool;
+    Config config;
+    std::shared_ptr<const Material> material;
+    std::unordered_map<uint64_t, Chunk> chunks;
+    Stats stats;
+
+    static uint64_t key(int x, int z)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(z);
+    }
+
+    // A resident LOD is kept while the distance stays within its band widened by the margin
+    bool keepsLod(int lod, float distance) const
+    {
+        if (lod < 0)
+            return false;
+        float margin = LOD_HYSTERESIS * config.LodDistance;
+        return (lod == 0 || distance >= lod * config.LodDistance - margin)
+            && (lod == config.MaxLod || distance < (lod + 1) * config.LodDistance + margin);
+    }
+
+    void startBuild(Chunk& chunk, int lod)
+    {
+        chunk.pendingLod = lod;
+        glm::vec2 origin = glm::vec2(chunk.x, chunk.z) * config.ChunkSize;
+        float size = config.ChunkSize;
+        std::function<float(float, float)> height = config.Height;
+        chunk.pending = pool.Enqueue([origin, size, lod, height] { return build(origin, size, lod, height); });
+    }
+
+    void finishBuild(Chunk& chunk)
+    {
+        Geometry geometry = chunk.pending.get();
+        if (chunk.mesh)
+            chunk.mesh->Release();
+        chunk.mesh = std::make_unique<Mesh>(geometry.vertices, geometry.indices, material, "ground");
+        chunk.min = geometry.min;
+        chunk.max = geometry.max;
+        chunk.lod = chunk.pendingLod;
+    }
+
+    // Runs on a worker thread. UVs are world positions, so the texture repeats once per meter across chunk seams.
+    static Geometry build(glm::vec2 origin, float size, int lod, const std::function<float(float, float)>& height)
+    {
+        const int quads = std::max(1, RESOLUTION >> lod);
+        const float step = size / quads;
+        auto heightAt = [&](float x, float z) { return height ? height(x, z) : 0.0f; };
+
+        Geometry geometry;
+        geometry.min = glm::vec3(origin.x, FLT_MAX, origin.y);
+        geometry.max = glm::vec3(origin.x + size, -FLT_MAX, origin.y + size);
+        geometry.vertices.reserve((quads + 1) * (quads + 1));
+        for (int row = 0; row <= quads; ++row)
+            for (int column = 0; column <= quads; ++column)
+            {
+                float x = origin.x + column * step, z = origin.y + row * step;
+                float y = heightAt(x, z);
+                glm::vec3 normal = glm::normalize(glm::vec3(heightAt(x - step, z) - heightAt(x + step, z), 2.0f * step,
+                    heightAt(x, z - step) - heightAt(x, z + step)));
+                geometry.vertices.push_back({ { x, y, z }, normal, { x, -z }, glm::ivec4(0), glm::vec4(0.0f) });
+                geometry.min.y = std::min(geometry.min.y, y);
+                geometry.max.y = std::max(geometry.max.y, y);
+            }
+
+        geometry.indices.reserve(quads * quads * 6);
+        for (int row = 0; row < quads; ++row)
+            for (int column = 0; column < quads; ++column)
+            {
+                GLuint v00 = row * (quads + 1) + column, v10 = v00 + 1;
+                GLuint v01 = v00 + (quads + 1), v11 = v01 + 1;
+                geometry.indices.insert(geometry.indices.end(), { v01, v11, v10, v10, v00, v01 });
+            }
+        return geometry;
+    }
+
+    // Planes of the frustum of a view-projection matrix, pointing inwards
+    static std::array<glm::vec4, 6> frustumPlanes(const glm::mat4& m)
+    {
+        glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+        glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+        glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+        glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+        return { row3 + row0, row3 - row0, row3 + row1, row3 - row1, row3 + row2, row3 - row2 };
+    }
+
+    static bool intersects(const std::array<glm::vec4, 6>& planes, const glm::vec3& min, const glm::vec3& max)
+    {
+        for (const glm::vec4& plane : planes)
+        {
+            // The box corner furthest along the plane's normal
+            glm::vec3 corner(plane.x >= 0.0f ? max.x : min.x, plane.y >= 0.0f ? max.y : min.y, plane.z >= 0.0f ? max.z : min.z);
+            if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+                return false;
+        }
+        return true;
+    }
+};
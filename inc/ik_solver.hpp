@@ -0,0 +1,289 @@
+#pragma once
+
+#include "bone_palette.hpp"
+#include "thread_pool.hpp"
+
+#include "ozz/animation/runtime/ik_aim_job.h"
+#include "ozz/animation/runtime/ik_two_bone_job.h"
+#include "ozz/base/maths/simd_math.h"
+#include "ozz/base/maths/simd_quaternion.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Foot placement (two-bone IK on each leg) and look-at (aim IK on the head) applied to sampled poses
+// after LocalToModel. Instances are collected during the frame and solved in chunks on the thread pool.
+// A chain whose end is already in place is not solved, and a chunk that has used up its instances'
+// time budget leaves the rest in their animated pose.
+class IKSolver
+{
+public:
+    struct Config
+    {
+        float BudgetMicroseconds = 20.0f; // Per instance and frame
+        float AimWeight = 0.7f;
+        float MaxAimAngle = 1.2f;         // Radians, targets further around are not looked at
+        float AimTolerance = 0.03f;       // Radians, heads already this close to the target are left alone
+        float MaxStep = 0.5f;             // Ground further above or below a foot is treated as a wall
+        float FootTolerance = 0.005f;     // Feet already this close to the ground are left alone
+        std::function<float(float x, float z)> GroundHeight; // World space, called from workers; none disables foot placement
+    };
+
+    struct Instance
+    {
+        glm::mat4 World;                    // Model to world
+        glm::vec3 LookTarget;               // World space
+        std::vector<glm::mat4>* ModelSpace; // Joint transforms without the inverse bind pose, corrected in place
+        BonePalette* Palette;               // Skinning matrices of the corrected joints are rewritten
+    };
+
+    struct Stats
+    {
+        size_t Instances = 0;
+        size_t Solved = 0;         // Chains
+        size_t Skipped = 0;        // Chains already in place
+        size_t Deferred = 0;       // Instances left animated once their chunk ran out of budget
+        double Microseconds = 0.0; // From Solve to the end of each chunk, summed over the chunks
+    };
+
+    // Finds the legs and the head by joint name suffix, e.g. Mixamo's "mixamorig:LeftUpLeg"; the bind pose
+    // must face +Z with +Y up
+    void Init(const std::vector<int>& parents, const std::vector<glm::mat4>& inverseBindPoses, const std::vector<std::string>& names)
+    {
+        inverseBind = inverseBindPoses;
+        const int numJoints = static_cast<int>(parents.size());
+        subtreeEnd.assign(numJoints, 0);
+        for (int i = numJoints - 1; i >= 0; --i)
+        {
+            subtreeEnd[i] = std::max(subtreeEnd[i], i);
+            if (parents[i] >= 0)
+                subtreeEnd[parents[i]] = std::max(subtreeEnd[parents[i]], subtreeEnd[i]);
+        }
+
+        auto find = [&](const std::string& suffix)
+        {
+            for (int i = 0; i < numJoints; ++i)
+                if (names[i].size() >= suffix.size() && names[i].compare(names[i].size() - suffix.size(), suffix.size(), suffix) == 0)
+                    return i;
+            return -1;
+        };
+        legs.clear();
+        for (const char* side : { "Left", "Right" })
+        {
+            Leg leg{ find(std::string(side) + "UpLeg"), find(std::string(side) + "Leg"), find(std::string(side) + "Foot") };
+            if (leg.hip >= 0 && leg.knee >= 0 && leg.ankle >= 0 && parents[leg.knee] == leg.hip && parents[leg.ankle] == leg.knee)
+                legs.push_back(leg);
+        }
+
+        // The head's local forward and up axes, from its bind pose
+        head = find("Head");
+        if (head >= 0)
+        {
+            glm::mat3 bindPose = glm::inverse(glm::mat3(unscaled(glm::inverse(inverseBind[head]))));
+            headForward = glm::normalize(bindPose * glm::vec3(0.0f, 0.0f, 1.0f));
+            headUp = glm::normalize(bindPose * glm::vec3(0.0f, 1.0f, 0.0f));
+        }
+    }
+
+    bool IsValid() const { return !legs.empty() || head >= 0; }
+
+    Config& GetConfig() { return config; }
+
+    void Add(const Instance& instance) { instances.push_back(instance); }
+
+    // Solves the instances added since the last call, in chunks on the pool when there is one. The budget
+    // runs from this call, so chunks that wait for a thread spend their instances' time too.
+    Stats Solve(ThreadPool* pool)
+    {
+        Stats stats;
+        stats.Instances = instances.size();
+        const auto start = std::chrono::steady_clock::now();
+        if (!pool || instances.size() <= CHUNK_SIZE)
+            add(stats, solveChunk(start, 0, instances.size()));
+        else
+        {
+            std::vector<Stats> chunks((instances.size() + CHUNK_SIZE - 1) / CHUNK_SIZE);
+            pool->ParallelFor(chunks.size(), [this, start, &chunks](size_t chunk) {
+                size_t begin = chunk * CHUNK_SIZE;
+                chunks[chunk] = solveChunk(start, begin, std::min(begin + CHUNK_SIZE, instances.size()));
+            });
+            for (const Stats& chunk : chunks)
+                add(stats, chunk);
+        }
+        instances.clear();
+        return stats;
+    }
+
+private:
+    static constexpr size_t CHUNK_SIZE = 32;
+
+    struct Leg
+    {
+        int hip, knee, ankle;
+    };
+
+    Config config;
+    std::vector<Leg> legs;
+    int head = -1;
+    glm::vec3 headForward{ 0.0f, 0.0f, 1.0f }, headUp{ 0.0f, 1.0f, 0.0f };
+    std::vector<glm::mat4> inverseBind;
+    std::vector<int> subtreeEnd;
+    std::vector<Instance> instances;
+
+    static void add(Stats& to, const Stats& from)
+    {
+        to.Solved += from.Solved;
+        to.Skipped += from.Skipped;
+        to.Deferred += from.Deferred;
+        to.Microseconds += from.Microseconds;
+    }
+
+    Stats solveChunk(std::chrono::steady_clock::time_point start, size_t begin, size_t end) const
+    {
+        Stats stats;
+        const auto deadline = start + std::chrono::duration<double, std::micro>(config.BudgetMicroseconds * (end - begin));
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+            {
+                stats.Deferred += end - i;
+                break;
+            }
+            const Instance& instance = instances[i];
+            const glm::mat4 toModel = glm::inverse(instance.World);
+            if (config.GroundHeight)
+                for (const Leg& leg : legs)
+                    solveLeg(instance, toModel, leg, stats);
+            if (head >= 0 && config.AimWeight > 0.0f)
+                solveAim(instance, toModel, stats);
+        }
+        stats.Microseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        return stats;
+    }
+
+    // Moves the ankle by the ground's height above the floor the clip was authored on, i.e. the
+    // instance's origin
+    void solveLeg(const Instance& instance, const glm::mat4& toModel, const Leg& leg, Stats& stats) const
+    {
+        std::vector<glm::mat4>& modelSpace = *instance.ModelSpace;
+        const glm::vec3 worldAnkle(instance.World * modelSpace[leg.ankle][3]);
+        const float offset = config.GroundHeight(worldAnkle.x, worldAnkle.z) - instance.World[3].y;
+        if (std::abs(offset) < config.FootTolerance || std::abs(offset) > config.MaxStep)
+        {
+            ++stats.Skipped;
+            return;
+        }
+        const glm::vec3 target(toModel * glm::vec4(worldAnkle + glm::vec3(0.0f, offset, 0.0f), 1.0f));
+
+        // Knee axis from the current bend, so the leg keeps folding the way the clip folds it; a positive
+        // rotation opens the knee
+        const glm::vec3 hip(modelSpace[leg.hip][3]), knee(modelSpace[leg.knee][3]), ankle(modelSpace[leg.ankle][3]);
+        glm::vec3 axis = glm::cross(ankle - knee, knee - hip);
+        axis = glm::length(axis) > 1e-6f ? glm::normalize(axis) : glm::vec3(-1.0f, 0.0f, 0.0f);
+        const glm::mat4 start = unscaled(modelSpace[leg.hip]), mid = unscaled(modelSpace[leg.knee]), end = unscaled(modelSpace[leg.ankle]);
+        const glm::vec3 midAxis = glm::normalize(glm::transpose(glm::mat3(mid)) * axis);
+
+        const ozz::math::Float4x4 startJoint = toOzz(start), midJoint = toOzz(mid), endJoint = toOzz(end);
+        ozz::math::SimdQuaternion startCorrection, midCorrection;
+        ozz::animation::IKTwoBoneJob job;
+        job.target = ozz::math::simd_float4::Load(target.x, target.y, target.z, 0.0f);
+        job.pole_vector = ozz::math::simd_float4::Load(0.0f, 0.0f, 1.0f, 0.0f); // Knees point forward
+        job.mid_axis = ozz::math::simd_float4::Load(midAxis.x, midAxis.y, midAxis.z, 0.0f);
+        job.start_joint = &startJoint;
+        job.mid_joint = &midJoint;
+        job.end_joint = &endJoint;
+        job.start_joint_correction = &startCorrection;
+        job.mid_joint_correction = &midCorrection;
+        if (!job.Run())
+        {
+            ++stats.Skipped;
+            return;
+        }
+
+        // The knee's correction uses its transform from before the hip's
+        applyCorrection(modelSpace, leg.knee, midCorrection);
+        applyCorrection(modelSpace, leg.hip, startCorrection);
+        updatePalette(instance, leg.hip);
+        ++stats.Solved;
+    }
+
+    void solveAim(const Instance& instance, const glm::mat4& toModel, Stats& stats) const
+    {
+        std::vector<glm::mat4>& modelSpace = *instance.ModelSpace;
+        const glm::mat4 joint = unscaled(modelSpace[head]);
+        const glm::vec3 target(toModel * glm::vec4(instance.LookTarget, 1.0f));
+        const glm::vec3 toTarget = target - glm::vec3(joint[3]);
+        if (glm::length(toTarget) < 1e-4f)
+        {
+            ++stats.Skipped;
+            return;
+        }
+        const float angle = std::acos(std::clamp(glm::dot(glm::normalize(glm::mat3(joint) * headForward), glm::normalize(toTarget)), -1.0f, 1.0f));
+        if (angle < config.AimTolerance || angle > config.MaxAimAngle)
+        {
+            ++stats.Skipped;
+            return;
+        }
+
+        const ozz::math::Float4x4 headJoint = toOzz(joint);
+        ozz::math::SimdQuaternion correction;
+        ozz::animation::IKAimJob job;
+        job.target = ozz::math::simd_float4::Load(target.x, target.y, target.z, 0.0f);
+        job.forward = ozz::math::simd_float4::Load(headForward.x, headForward.y, headForward.z, 0.0f);
+        job.up = ozz::math::simd_float4::Load(headUp.x, headUp.y, headUp.z, 0.0f);
+        job.pole_vector = ozz::math::simd_float4::Load(0.0f, 1.0f, 0.0f, 0.0f);
+        job.weight = config.AimWeight;
+        job.joint = &headJoint;
+        job.joint_correction = &correction;
+        if (!job.Run())
+        {
+            ++stats.Skipped;
+            return;
+        }
+
+        applyCorrection(modelSpace, head, correction);
+        updatePalette(instance, head);
+        ++stats.Solved;
+    }
+
+    // A local rotation of the joint, applied in model space to the joint and everything under it
+    void applyCorrection(std::vector<glm::mat4>& modelSpace, int joint, const ozz::math::SimdQuaternion& correction) const
+    {
+        float xyzw[4];
+        ozz::math::StorePtrU(correction.xyzw, xyzw);
+        const glm::mat4 rotation = glm::mat4_cast(glm::quat(xyzw[3], xyzw[0], xyzw[1], xyzw[2]));
+        const glm::mat4 delta = modelSpace[joint] * rotation * glm::inverse(modelSpace[joint]);
+        for (int i = joint; i <= subtreeEnd[joint]; ++i)
+            modelSpace[i] = delta * modelSpace[i];
+    }
+
+    void updatePalette(const Instance& instance, int joint) const
+    {
+        for (int i = joint; i <= subtreeEnd[joint]; ++i)
+            (*instance.Palette)[i] = (*instance.ModelSpace)[i] * inverseBind[i];
+    }
+
+    // The import's global scale is uniform; the IK jobs expect orthonormal joint axes
+    static glm::mat4 unscaled(glm::mat4 m)
+    {
+        for (int column = 0; column < 3; ++column)
+            m[column] = glm::normalize(m[column]);
+        return m;
+    }
+
+    static ozz::math::Float4x4 toOzz(const glm::mat4& from)
+    {
+        ozz::math::Float4x4 to;
+        memcpy(&to.cols[0], glm::value_ptr(from), sizeof(glm::mat4));
+        return to;
+    }
+};
@@ -0,0 +1,260 @@
+#pragma once
+
+#include "thread_pool.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define IMAGE_DECODER_SSE 1
+#endif
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <future>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// A single decoded mip level, tightly packed
+struct ImageLevel
+{
+    unsigned int width = 0;
+    unsigned int height = 0;
+    std::vector<unsigned char> pixels;
+};
+
+struct DecodedImage
+{
+    int channels = 0;
+    size_t sourceBytes = 0;         // Compressed size, for throughput reporting
+    std::vector<ImageLevel> levels; // Finest first, down to 1x1
+
+    bool IsValid() const { return !levels.empty(); }
+};
+
+// Decodes images with stb_image and builds their mip chains on the CPU, filtering color in linear space.
+// All functions are thread-safe so decodes can run on a ThreadPool and hand their levels to the GL thread.
+class ImageDecoder
+{
+public:
+    // desiredChannels = 0 keeps the image's own channel count
+    static DecodedImage DecodeFile(const std::string& path, int desiredChannels = 0, bool srgb = true)
+    {
+        DecodedImage decoded;
+        int width, height, channels;
+        unsigned char* image = stbi_load(path.c_str(), &width, &height, &channels, desiredChannels);
+        if (!image)
+            return decoded;
+
+        std::error_code error;
+        decoded.sourceBytes = static_cast<size_t>(std::filesystem::file_size(path, error));
+        finish(decoded, image, width, height, desiredChannels ? desiredChannels : channels, srgb);
+        return decoded;
+    }
+
+    static DecodedImage DecodeMemory(const unsigned char* data, size_t size, int desiredChannels = 0, bool srgb = true)
+    {
+        DecodedImage decoded;
+        int width, height, channels;
+        unsigned char* image = stbi_load_from_memory(data, static_cast<int>(size), &width, &height, &channels, desiredChannels);
+        if (!image)
+            return decoded;
+
+        decoded.sourceBytes = size;
+        finish(decoded, image, width, height, desiredChannels ? desiredChannels : channels, srgb);
+        return decoded;
+    }
+
+    // Reads only the header, e.g. to reserve space for an image before it is decoded
+    static bool ReadDimensions(const std::string& path, unsigned int& width, unsigned int& height)
+    {
+        int w, h, channels;
+        if (!stbi_info(path.c_str(), &w, &h, &channels))
+            return false;
+        width = static_cast<unsigned int>(w);
+        height = static_cast<unsigned int>(h);
+        return true;
+    }
+
+    static std::future<DecodedImage> DecodeFileAsync(ThreadPool& pool, const std::string& path, int desiredChannels = 0, bool srgb = true)
+    {
+        return pool.Enqueue([path, desiredChannels, srgb] { return DecodeFile(path, desiredChannels, srgb); });
+    }
+
+    // Append mips to levels[0] down to 1x1 with a 2x2 box filter
+    static void BuildMipChain(std::vector<ImageLevel>& levels, int channels, bool srgb)
+    {
+        while (levels.back().width > 1 || levels.back().height > 1)
+            levels.push_back(downsample(levels.back(), channels, srgb));
+    }
+
+    // Decode every image in a directory, single-threaded and then on the pool, and report throughput
+    static void Benchmark(ThreadPool& pool, const std::string& directory)
+    {
+        std::vector<std::string> paths;
+        std::error_code error;
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(directory, error))
+        {
+            std::string extension = entry.path().extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+            if (extension == ".png" || extension == ".jpg" || extension == ".jpeg")
+                paths.push_back(entry.path().string());
+        }
+        if (paths.empty())
+        {
+            std::cerr << "ERROR::IMAGEDECODER: No images found in \"" << directory << "\"" << std::endl;
+            return;
+        }
+
+        auto report = [&](const char* label, const std::vector<DecodedImage>& images, double seconds)
+            {
+                size_t sourceBytes = 0, decodedBytes = 0;
+                for (const auto& image : images)
+                {
+                    sourceBytes += image.sourceBytes;
+                    for (const auto& level : image.levels)
+                        decodedBytes += level.pixels.size();
+                }
+                std::cout << "Image decode (" << label << "): " << images.size() << " images in " << seconds * 1000.0 << " ms"
+                    << ", " << (sourceBytes / (1024.0 * 1024.0)) / seconds << " MB/s compressed"
+                    << ", " << (decodedBytes / (1024.0 * 1024.0)) / seconds << " MB/s decoded with mips"
+                    << std::endl;
+            };
+
+        std::vector<DecodedImage> images;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& path : paths)
+            images.push_back(DecodeFile(path));
+        report("1 thread", images, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+        images.clear();
+        start = std::chrono::steady_clock::now();
+        std::vector<std::future<DecodedImage>> futures;
+        for (const auto& path : paths)
+            futures.push_back(DecodeFileAsync(pool, path));
+        for (auto& future : futures)
+            images.push_back(future.get());
+        std::string label = std::to_string(pool.GetNumThreads()) + " threads";
+        report(label.c_str(), images, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+
+private:
+    static void finish(DecodedImage& decoded, unsigned char* image, int width, int height, int channels, bool srgb)
+    {
+        decoded.channels = channels;
+        decoded.levels.resize(1);
+        decoded.levels[0].width = width;
+        decoded.levels[0].height = height;
+        decoded.levels[0].pixels.assign(image, image + static_cast<size_t>(width) * height * channels);
+        stbi_image_free(image);
+        BuildMipChain(decoded.levels, channels, srgb);
+    }
+
+    static const std::array<float, 256>& toLinearTable()
+    {
+        static const std::array<float, 256> table = [] {
+            std::array<float, 256> t;
+            for (int i = 0; i < 256; ++i)
+            {
+                float c = i / 255.0f;
+                t[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+            return t;
+        }();
+        return table;
+    }
+
+    static const std::array<unsigned char, 4096>& toSrgbTable()
+    {
+        static const std::array<unsigned char, 4096> table = [] {
+            std::array<unsigned char, 4096> t;
+            for (int i = 0; i < 4096; ++i)
+            {
+                float l = i / 4095.0f;
+                float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+                t[i] = static_cast<unsigned char>(std::clamp(c * 255.0f + 0.5f, 0.0f, 255.0f));
+            }
+            return t;
+        }();
+        return table;
+    }
+
+    static ImageLevel downsample(const ImageLevel& src, int channels, bool srgb)
+    {
+        ImageLevel dst;
+        dst.width = std::max(src.width / 2, 1u);
+        dst.height = std::max(src.height / 2, 1u);
+        dst.pixels.resize(static_cast<size_t>(dst.width) * dst.height * channels);
+
+        const auto& toLinear = toLinearTable();
+        const auto& toSrgb = toSrgbTable();
+        // Color channels are averaged in linear space, alpha and non-color data as-is
+        const int colorChannels = srgb ? std::min(channels, 3) : 0;
+
+        for (unsigned int y = 0; y < dst.height; ++y)
+        {
+            // Clamp at odd edges
+            unsigned int y0 = std::min(y * 2, src.height - 1), y1 = std::min(y * 2 + 1, src.height - 1);
+            unsigned int x = 0;
+#ifdef IMAGE_DECODER_SSE
+            // Color goes through the lookup tables, so only linear RGBA rows have a vector path
+            if (channels == 4 && !colorChannels)
+                x = downsampleRowSse(&src.pixels[static_cast<size_t>(y0) * src.width * 4], &src.pixels[static_cast<size_t>(y1) * src.width * 4],
+                    &dst.pixels[static_cast<size_t>(y) * dst.width * 4], dst.width, src.width);
+#endif
+            for (; x < dst.width; ++x)
+            {
+                unsigned int x0 = std::min(x * 2, src.width - 1), x1 = std::min(x * 2 + 1, src.width - 1);
+                const unsigned char* p[4] = {
+                    &src.pixels[(static_cast<size_t>(y0) * src.width + x0) * channels],
+                    &src.pixels[(static_cast<size_t>(y0) * src.width + x1) * channels],
+                    &src.pixels[(static_cast<size_t>(y1) * src.width + x0) * channels],
+                    &src.pixels[(static_cast<size_t>(y1) * src.width + x1) * channels]
+                };
+                unsigned char* out = &dst.pixels[(static_cast<size_t>(y) * dst.width + x) * channels];
+
+                for (int c = 0; c < channels; ++c)
+                {
+                    if (c < colorChannels)
+                    {
+                        float avg = (toLinear[p[0][c]] + toLinear[p[1][c]] + toLinear[p[2][c]] + toLinear[p[3][c]]) * 0.25f;
+                        out[c] = toSrgb[static_cast<int>(avg * 4095.0f + 0.5f)];
+                    }
+                    else
+                        out[c] = static_cast<unsigned char>((p[0][c] + p[1][c] + p[2][c] + p[3][c] + 2) / 4);
+                }
+            }
+        }
+        return dst;
+    }
+
+#ifdef IMAGE_DECODER_SSE
+    // Two RGBA output pixels per iteration from 16 bytes of each source row, widened to 16-bit lanes so the
+    // result matches the scalar (a + b + c + d + 2) / 4. Returns the first pixel left to the scalar loop,
+    // which also handles the clamped odd edge.
+    static unsigned int downsampleRowSse(const unsigned char* row0, const unsigned char* row1, unsigned char* out,
+        unsigned int dstWidth, unsigned int srcWidth)
+    {
+        const __m128i zero = _mm_setzero_si128(), round = _mm_set1_epi16(2);
+        unsigned int x = 0;
+        for (; x + 1 < dstWidth && x * 2 + 3 < srcWidth; x += 2)
+        {
+            __m128i top = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8));
+            __m128i bottom = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8));
+            // Source pixels 0-1 and 2-3 with both rows added, then each pixel added to its right neighbor
+            __m128i left = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+            __m128i right = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+            left = _mm_add_epi16(left, _mm_srli_si128(left, 8));
+            right = _mm_add_epi16(right, _mm_srli_si128(right, 8));
+            __m128i average = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(left, right), round), 2);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x * 4), _mm_packus_epi16(average, zero));
+        }
+        return x;
+    }
+#endif
+};
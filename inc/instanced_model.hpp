@@ -0,0 +1,125 @@
+#pragma once
+
+#include "basic_model.hpp"
+#include "gl_state.hpp"
+#include "gpu_memory.hpp"
+#include "shader.hpp"
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Copies of one static model drawn with one glDrawElementsInstanced per mesh. Model matrices live in a
+// per-instance vertex buffer read by default.vs; edits widen a dirty range and only that range is
+// uploaded before the next draw, so moving a few props does not resend the rest.
+class InstancedModel
+{
+public:
+    InstancedModel(std::shared_ptr<const BasicModel> model, const std::string& asset = "instances")
+        : model(std::move(model)), asset(asset)
+    {}
+
+    ~InstancedModel()
+    {
+        GLState& glState = GLState::GetInstance();
+        for (GLuint vertexArray : vertexArrays)
+            glState.DeleteVertexArray(vertexArray);
+        if (instanceBuffer != 0)
+        {
+            GpuMemory::GetInstance().ReleaseBuffer(instanceBuffer);
+            glState.DeleteBuffer(instanceBuffer);
+        }
+    }
+
+    InstancedModel(const InstancedModel&) = delete;
+    InstancedModel& operator=(const InstancedModel&) = delete;
+
+    // Returns the instance's index, stable for the lifetime of the batch. Scale must be uniform, default.vs
+    // transforms normals by the matrix itself
+    size_t Add(const glm::mat4& transform)
+    {
+        transforms.push_back(transform);
+        markDirty(transforms.size() - 1);
+        return transforms.size() - 1;
+    }
+
+    void Set(size_t index, const glm::mat4& transform)
+    {
+        transforms[index] = transform;
+        markDirty(index);
+    }
+
+    const glm::mat4& Get(size_t index) const { return transforms[index]; }
+    size_t GetCount() const { return transforms.size(); }
+
+    // Uploads what changed since the last draw, then draws every instance
+    void Draw(const Shader& shader)
+    {
+        if (transforms.empty())
+            return;
+        upload();
+        shader.Use();
+        shader.SetBool("animated", false);
+        shader.SetBool("instanced", true);
+        const auto& meshes = model->GetMeshes();
+        for (size_t i = 0; i < meshes.size(); ++i)
+            meshes[i].DrawInstanced(shader, static_cast<GLsizei>(transforms.size()), vertexArrays[i]);
+        shader.SetBool("instanced", false);
+    }
+
+private:
+    std::shared_ptr<const BasicModel> model;
+    std::string asset;
+    std::vector<glm::mat4> transforms;
+    std::vector<GLuint> vertexArrays; // One per mesh, over the mesh's buffers and the instance buffer
+    GLuint instanceBuffer = 0;
+    size_t capacity = 0;
+    size_t dirtyBegin = 0, dirtyEnd = 0; // Instances [dirtyBegin, dirtyEnd) differ from the buffer
+
+    void markDirty(size_t index)
+    {
+        if (dirtyBegin == dirtyEnd)
+        {
+            dirtyBegin = index;
+            dirtyEnd = index + 1;
+        }
+        else
+        {
+            dirtyBegin = std::min(dirtyBegin, index);
+            dirtyEnd = std::max(dirtyEnd, index + 1);
+        }
+    }
+
+    void upload()
+    {
+        GLState& glState = GLState::GetInstance();
+        if (instanceBuffer == 0)
+        {
+            glGenBuffers(1, &instanceBuffer);
+            for (const auto& mesh : model->GetMeshes())
+                vertexArrays.push_back(mesh.CreateInstancedVertexArray(instanceBuffer));
+        }
+
+        // Growing reallocates and sends everything, with room to spare for the next additions
+        if (transforms.size() > capacity)
+        {
+            capacity = std::max(transforms.size(), capacity * 2);
+            glState.BindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+            glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
+            GpuMemory::GetInstance().TrackBuffer(instanceBuffer, capacity * sizeof(glm::mat4), GpuMemoryCategory::Vertex, asset);
+            dirtyBegin = 0;
+            dirtyEnd = transforms.size();
+        }
+        if (dirtyBegin == dirtyEnd)
+            return;
+
+        glState.BindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        glState.BufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(dirtyBegin * sizeof(glm::mat4)),
+            static_cast<GLsizeiptr>((dirtyEnd - dirtyBegin) * sizeof(glm::mat4)), transforms.data() + dirtyBegin);
+        dirtyBegin = dirtyEnd = 0;
+    }
+};
@@ -0,0 +1,325 @@
+#pragma once
+
+#include "gl_state.hpp"
+#include "gpu_memory.hpp"
+#include "shader.hpp"
+#include "thread_pool.hpp"
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LIGHT_CLUSTERS_SSE 1
+#endif
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Clustered forward lighting. The view frustum is split into a grid of clusters, screen tiles times
+// exponential depth slices, and every frame each cluster gets the list of point and spot lights whose
+// range touches it. Lists are built on the CPU, slices in parallel on the pool, and read by default.fs
+// from buffer textures, so a fragment only loops over the few lights of its own cluster.
+class LightClusters
+{
+public:
+    static constexpr int GRID_X = 16, GRID_Y = 9, GRID_Z = 24; // Matches default.fs
+    static constexpr int NUM_CLUSTERS = GRID_X * GRID_Y * GRID_Z;
+    static constexpr uint32_t MAX_LIGHTS_PER_CLUSTER = 128;
+
+    struct Light
+    {
+        glm::vec3 Position;
+        float Radius; // Influence ends here
+        glm::vec3 Color;
+        glm::vec3 Direction = glm::vec3(0.0f, -1.0f, 0.0f); // Spot lights only
+        float InnerCos = -1.0f; // Cosines of the cone's full-intensity and cut-off half angles,
+        float OuterCos = -1.0f; // -1 for a point light
+    };
+
+    struct Stats
+    {
+        unsigned int Lights = 0;
+        unsigned int Assignments = 0; // Light indices over all clusters
+        unsigned int MaxPerCluster = 0;
+        float Microseconds = 0.0f; // Wall time of Build, waiting for threads included
+    };
+
+    ~LightClusters()
+    {
+        GLState& glState = GLState::GetInstance();
+        GpuMemory& gpuMemory = GpuMemory::GetInstance();
+        for (size_t i = 0; i < textures.size(); ++i)
+            if (textures[i] != 0)
+            {
+                glDeleteTextures(1, &textures[i]);
+                gpuMemory.ReleaseBuffer(buffers[i]);
+                glState.DeleteBuffer(buffers[i]);
+            }
+    }
+
+    // Sampler units of the cluster buffers, set once per program using default.fs so they never alias
+    // another sampler type on unit 0
+    static void SetSamplerUnits(const Shader& shader)
+    {
+        shader.Use();
+        shader.SetInt("clusterGrid", static_cast<int>(GRID_UNIT));
+        shader.SetInt("clusterLightIndices", static_cast<int>(INDEX_UNIT));
+        shader.SetInt("clusterLights", static_cast<int>(LIGHT_UNIT));
+    }
+
+    // Assigns the lights to the clusters of the view and uploads the result
+    void Build(const std::vector<Light>& lights, const glm::mat4& view, const glm::mat4& projection, float nearPlane, float farPlane,
+        ThreadPool* pool)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        if (projection != clusterProjection || nearPlane != clusterNear || farPlane != clusterFar)
+            computeBounds(projection, nearPlane, farPlane);
+
+        // View-space spheres as structure of arrays, each slice packs its candidates from them
+        centerX.resize(lights.size());
+        centerY.resize(lights.size());
+        centerZ.resize(lights.size());
+        radii.resize(lights.size());
+        radiusSquared.resize(lights.size());
+        for (size_t i = 0; i < lights.size(); ++i)
+        {
+            glm::vec3 center = glm::vec3(view * glm::vec4(lights[i].Position, 1.0f));
+            centerX[i] = center.x;
+            centerY[i] = center.y;
+            centerZ[i] = center.z;
+            radii[i] = lights[i].Radius;
+            radiusSquared[i] = lights[i].Radius * lights[i].Radius;
+        }
+
+        if (!pool || lights.size() < 32)
+            for (int z = 0; z < GRID_Z; ++z)
+                assignSlice(z);
+        else
+        {
+            pool->ParallelFor((GRID_Z + SLICES_PER_TASK - 1) / SLICES_PER_TASK, [this](size_t task) {
+                int z = static_cast<int>(task) * SLICES_PER_TASK;
+                for (int slice = z; slice < std::min(z + SLICES_PER_TASK, GRID_Z); ++slice)
+                    assignSlice(slice);
+            });
+        }
+
+        // Slices into one offset and count per cluster and one index list
+        stats = {};
+        stats.Lights = static_cast<unsigned int>(lights.size());
+        grid.resize(NUM_CLUSTERS * 2);
+        indices.clear();
+        for (int z = 0; z < GRID_Z; ++z)
+        {
+            const Slice& slice = slices[z];
+            uint32_t sliceOffset = static_cast<uint32_t>(indices.size());
+            for (int tile = 0; tile < GRID_X * GRID_Y; ++tile)
+            {
+                int cluster = z * GRID_X * GRID_Y + tile;
+                grid[cluster * 2] = sliceOffset + slice.offsets[tile];
+                grid[cluster * 2 + 1] = slice.counts[tile];
+                stats.MaxPerCluster = std::max(stats.MaxPerCluster, slice.counts[tile]);
+            }
+            indices.insert(indices.end(), slice.indices.begin(), slice.indices.end());
+        }
+        stats.Assignments = static_cast<unsigned int>(indices.size());
+
+        // Three texels per light: position and radius, color and outer cosine, direction and inner cosine
+        lightTexels.resize(std::max<size_t>(lights.size(), 1) * 3, glm::vec4(0.0f));
+        for (size_t i = 0; i < lights.size(); ++i)
+        {
+            lightTexels[i * 3] = glm::vec4(lights[i].Position, lights[i].Radius);
+            lightTexels[i * 3 + 1] = glm::vec4(lights[i].Color, lights[i].OuterCos);
+            lightTexels[i * 3 + 2] = glm::vec4(glm::normalize(lights[i].Direction), lights[i].InnerCos);
+        }
+        if (indices.empty())
+            indices.push_back(0); // Buffer textures need storage even when no cluster references it
+
+        upload(GRID, grid.data(), grid.size() * sizeof(uint32_t), GL_RG32UI);
+        upload(INDEX, indices.data(), indices.size() * sizeof(uint32_t), GL_R32UI);
+        upload(LIGHT, lightTexels.data(), lightTexels.size() * sizeof(glm::vec4), GL_RGBA32F);
+        stats.Microseconds = std::chrono::duration<float, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    // Binds the cluster buffers and sets what default.fs needs to find a fragment's cluster
+    void Bind(const Shader& shader, const glm::vec2& screenSize) const
+    {
+        shader.Use();
+        shader.SetFloat("clusterNear", clusterNear);
+        shader.SetFloat("clusterScale", GRID_Z / std::log(clusterFar / clusterNear));
+        shader.SetVec2("clusterScreenSize", screenSize);
+        GLState& glState = GLState::GetInstance();
+        const GLuint units[] = { GRID_UNIT, INDEX_UNIT, LIGHT_UNIT };
+        for (size_t i = 0; i < textures.size(); ++i)
+        {
+            glState.BindTexture(units[i], GL_TEXTURE_BUFFER, textures[i]);
+            glState.BindSampler(units[i], 0);
+        }
+    }
+
+    const Stats& GetStats() const { return stats; }
+
+private:
+    // Units 0-6 are taken by materials, the shadow map and the GPU crowd
+    static constexpr GLuint GRID_UNIT = 7;
+    static constexpr GLuint INDEX_UNIT = 8;
+    static constexpr GLuint LIGHT_UNIT = 9;
+    static constexpr int SLICES_PER_TASK = 4;
+    enum Buffer { GRID, INDEX, LIGHT };
+
+    struct Bounds
+    {
+        glm::vec3 min, max;
+    };
+
+    // Lights of one depth slice, written by one task
+    struct Slice
+    {
+        std::array<uint32_t, GRID_X * GRID_Y> offsets, counts;
+        std::vector<uint32_t> indices;
+        std::vector<uint32_t> candidates; // Lights overlapping the slice's depth range
+        std::vector<float> x, y, z, radiusSquared; // Their view-space spheres
+    };
+
+    std::array<Bounds, NUM_CLUSTERS> bounds; // View space
+    std::array<float, GRID_Z + 1> sliceDepths;
+    glm::mat4 clusterProjection{ 0.0f };
+    float clusterNear = 0.1f, clusterFar = 100.0f;
+    std::vector<float> centerX, centerY, centerZ, radiusSquared, radii;
+    std::array<Slice, GRID_Z> slices;
+    std::vector<uint32_t> grid, indices;
+    std::vector<glm::vec4> lightTexels;
+    std::array<GLuint, 3> textures{}, buffers{};
+    Stats stats;
+
+    void computeBounds(const glm::mat4& projection, float nearPlane, float farPlane)
+    {
+        clusterProjection = projection;
+        clusterNear = nearPlane;
+        clusterFar = farPlane;
+        for (int z = 0; z <= GRID_Z; ++z)
+            sliceDepths[z] = nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(z) / GRID_Z);
+
+        // Each tile corner as a view-space ray scaled to unit depth, then stretched to the slice depths
+        const glm::mat4 inverse = glm::inverse(projection);
+        auto cornerRay = [&](int x, int y)
+        {
+            glm::vec4 point = inverse * glm::vec4(-1.0f + 2.0f * x / GRID_X, -1.0f + 2.0f * y / GRID_Y, -1.0f, 1.0f);
+            glm::vec3 view = glm::vec3(point) / point.w;
+            return view / -view.z;
+        };
+        for (int y = 0; y < GRID_Y; ++y)
+            for (int x = 0; x < GRID_X; ++x)
+            {
+                const glm::vec3 rays[4] = { cornerRay(x, y), cornerRay(x + 1, y), cornerRay(x, y + 1), cornerRay(x + 1, y + 1) };
+                for (int z = 0; z < GRID_Z; ++z)
+                {
+                    Bounds& box = bounds[(z * GRID_Y + y) * GRID_X + x];
+                    box.min = glm::vec3(FLT_MAX);
+                    box.max = glm::vec3(-FLT_MAX);
+                    for (const glm::vec3& ray : rays)
+                        for (float depth : { sliceDepths[z], sliceDepths[z + 1] })
+                        {
+                            box.min = glm::min(box.min, ray * depth);
+                            box.max = glm::max(box.max, ray * depth);
+                        }
+                }
+            }
+    }
+
+    void assignSlice(int z)
+    {
+        // Lights overlapping the slice's depth range, packed contiguously and padded to whole SIMD lanes
+        // with spheres that touch nothing
+        Slice& slice = slices[z];
+        slice.indices.clear();
+        slice.candidates.clear();
+        slice.x.clear();
+        slice.y.clear();
+        slice.z.clear();
+        slice.radiusSquared.clear();
+        const float nearDepth = sliceDepths[z], farDepth = sliceDepths[z + 1];
+        for (size_t i = 0; i < radii.size(); ++i)
+            if (-centerZ[i] + radii[i] >= nearDepth && -centerZ[i] - radii[i] <= farDepth)
+            {
+                slice.candidates.push_back(static_cast<uint32_t>(i));
+                slice.x.push_back(centerX[i]);
+                slice.y.push_back(centerY[i]);
+                slice.z.push_back(centerZ[i]);
+                slice.radiusSquared.push_back(radiusSquared[i]);
+            }
+        while (slice.x.size() % 4 != 0)
+        {
+            slice.x.push_back(1e30f);
+            slice.y.push_back(1e30f);
+            slice.z.push_back(1e30f);
+            slice.radiusSquared.push_back(0.0f);
+        }
+
+        for (int tile = 0; tile < GRID_X * GRID_Y; ++tile)
+        {
+            slice.offsets[tile] = static_cast<uint32_t>(slice.indices.size());
+            if (!slice.candidates.empty())
+                assignCluster(bounds[z * GRID_X * GRID_Y + tile], slice);
+            slice.counts[tile] = static_cast<uint32_t>(slice.indices.size()) - slice.offsets[tile];
+        }
+    }
+
+    // Sphere against box, four candidates at a time: the squared distance from each center to the box
+    void assignCluster(const Bounds& box, Slice& slice)
+    {
+        const size_t begin = slice.indices.size();
+#ifdef LIGHT_CLUSTERS_SSE
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 minX = _mm_set1_ps(box.min.x), minY = _mm_set1_ps(box.min.y), minZ = _mm_set1_ps(box.min.z);
+        const __m128 maxX = _mm_set1_ps(box.max.x), maxY = _mm_set1_ps(box.max.y), maxZ = _mm_set1_ps(box.max.z);
+        for (size_t i = 0; i < slice.candidates.size(); i += 4)
+        {
+            __m128 x = _mm_loadu_ps(&slice.x[i]), y = _mm_loadu_ps(&slice.y[i]), z = _mm_loadu_ps(&slice.z[i]);
+            __m128 dx = _mm_add_ps(_mm_max_ps(_mm_sub_ps(minX, x), zero), _mm_max_ps(_mm_sub_ps(x, maxX), zero));
+            __m128 dy = _mm_add_ps(_mm_max_ps(_mm_sub_ps(minY, y), zero), _mm_max_ps(_mm_sub_ps(y, maxY), zero));
+            __m128 dz = _mm_add_ps(_mm_max_ps(_mm_sub_ps(minZ, z), zero), _mm_max_ps(_mm_sub_ps(z, maxZ), zero));
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+            unsigned int hits = static_cast<unsigned int>(_mm_movemask_ps(_mm_cmple_ps(distance, _mm_loadu_ps(&slice.radiusSquared[i]))));
+            while (hits != 0)
+            {
+                slice.indices.push_back(slice.candidates[i + std::countr_zero(hits)]);
+                hits &= hits - 1;
+            }
+        }
+#else
+        for (size_t i = 0; i < slice.candidates.size(); ++i)
+        {
+            glm::vec3 center(slice.x[i], slice.y[i], slice.z[i]);
+            glm::vec3 offset = glm::max(box.min - center, 0.0f) + glm::max(center - box.max, 0.0f);
+            if (glm::dot(offset, offset) <= slice.radiusSquared[i])
+                slice.indices.push_back(slice.candidates[i]);
+        }
+#endif
+        if (slice.indices.size() - begin > MAX_LIGHTS_PER_CLUSTER)
+            slice.indices.resize(begin + MAX_LIGHTS_PER_CLUSTER);
+    }
+
+    // Orphans and refills one buffer texture's storage
+    void upload(Buffer buffer, const void* data, size_t bytes, GLenum format)
+    {
+        GLState& glState = GLState::GetInstance();
+        if (textures[buffer] == 0)
+        {
+            glGenBuffers(1, &buffers[buffer]);
+            glGenTextures(1, &textures[buffer]);
+            glState.BindBuffer(GL_TEXTURE_BUFFER, buffers[buffer]);
+            glState.BindTexture(GL_TEXTURE_BUFFER, textures[buffer]);
+            glTexBuffer(GL_TEXTURE_BUFFER, format, buffers[buffer]);
+        }
+        glState.BindBuffer(GL_TEXTURE_BUFFER, buffers[buffer]);
+        glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(bytes), data, GL_STREAM_DRAW);
+        GpuMemory::GetInstance().TrackBuffer(buffers[buffer], bytes, GpuMemoryCategory::Texture, "light clusters"); // Sampled as textures
+    }
+};
@@ -0,0 +1,186 @@
+#pragma once
+
+#include "gl_state.hpp"
+#include "sampler_cache.hpp"
+#include "shader.hpp"
+#include "texture_2D.hpp"
+
+#include <glad/gl.h>
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+enum class TextureSlot
+{
+    Diffuse,
+    Specular,
+    Normal,
+    Count
+};
+
+struct Texture
+{
+    Texture2D texture;
+    TextureSlot slot;
+    std::string path;
+};
+
+// Textures of a mesh resolved at import into fixed slots. Binding walks a precomputed table,
+// and per-material uniforms are only set when the shader's current material changes.
+class Material
+{
+public:
+    // Units 0-2 hold the 2D slot textures, 3 the shadow map, diffuse arrays use their own unit
+    static constexpr GLuint ARRAY_TEXTURE_UNIT = 4;
+
+    Material()
+        : id(nextID()), diffuseLayer(-1), sortKey(0)
+    {
+        hasTexture.fill(false);
+        rebuild();
+    }
+
+    // Keeps the first texture of each slot, as the shader only samples *0
+    Material(const std::vector<Texture>& textures)
+        : Material()
+    {
+        for (const auto& texture : textures)
+            setTexture(texture, false);
+        rebuild();
+    }
+
+    // Copies get their own id, so programs do not mistake them for the original
+    Material(const Material& other)
+        : textures(other.textures), hasTexture(other.hasTexture), id(nextID())
+    {
+        rebuild();
+    }
+
+    Material& operator=(const Material&) = delete;
+
+    void SetTexture(const Texture& texture)
+    {
+        setTexture(texture, true);
+        rebuild();
+    }
+
+    const Texture* GetTexture(TextureSlot slot) const
+    {
+        size_t index = static_cast<size_t>(slot);
+        return hasTexture[index] ? &textures[index] : nullptr;
+    }
+
+    // Orders draws so meshes sharing a diffuse texture (or texture array) are adjacent
+    uint64_t GetSortKey() const { return sortKey; }
+
+    void Bind(const Shader& shader) const
+    {
+        GLState& glState = GLState::GetInstance();
+        for (const auto& binding : bindings)
+        {
+            glState.BindTexture(binding.unit, binding.target, binding.texture);
+            glState.BindSampler(binding.unit, binding.sampler);
+        }
+
+        if (shader.CurrentMaterial != id)
+        {
+            shader.SetInt("diffuseLayer", diffuseLayer);
+            shader.CurrentMaterial = id;
+        }
+    }
+
+    // Sampler units are fixed per slot, so they are set once per program instead of per draw
+    static void SetSamplerUnits(const Shader& shader)
+    {
+        shader.Use();
+        shader.SetInt("texture_diffuse0", unitFor(TextureSlot::Diffuse));
+        shader.SetInt("texture_specular0", unitFor(TextureSlot::Specular));
+        shader.SetInt("texture_normal0", unitFor(TextureSlot::Normal));
+        shader.SetInt("texture_diffuse_array0", ARRAY_TEXTURE_UNIT);
+    }
+
+    static const char* SlotName(TextureSlot slot)
+    {
+        switch (slot)
+        {
+        case TextureSlot::Diffuse:  return "diffuse";
+        case TextureSlot::Specular: return "specular";
+        case TextureSlot::Normal:   return "normal";
+        default:                    return "unknown";
+        }
+    }
+
+    void Debug() const
+    {
+        for (size_t i = 0; i < textures.size(); ++i)
+            if (hasTexture[i])
+                std::cout << "Texture: " << textures[i].path << ", slot: " << SlotName(textures[i].slot) << std::endl;
+    }
+
+private:
+    struct Binding
+    {
+        GLuint unit;
+        GLenum target;
+        GLuint texture;
+        GLuint sampler;
+    };
+
+    static constexpr size_t NUM_SLOTS = static_cast<size_t>(TextureSlot::Count);
+
+    std::array<Texture, NUM_SLOTS> textures;
+    std::array<bool, NUM_SLOTS> hasTexture;
+    std::vector<Binding> bindings;
+    unsigned int id;
+    GLint diffuseLayer;
+    uint64_t sortKey;
+
+    static unsigned int nextID()
+    {
+        static unsigned int counter = 0;
+        return ++counter; // 0 means no material bound
+    }
+
+    static GLuint unitFor(TextureSlot slot) { return static_cast<GLuint>(slot); }
+
+    void setTexture(const Texture& texture, bool replace)
+    {
+        if (texture.slot == TextureSlot::Count)
+            return;
+        if (texture.texture.Target == GL_TEXTURE_2D_ARRAY && texture.slot != TextureSlot::Diffuse)
+        {
+            std::cerr << "ERROR::MATERIAL: Texture arrays are only supported in the diffuse slot: " << texture.path << std::endl;
+            return;
+        }
+        size_t index = static_cast<size_t>(texture.slot);
+        if (hasTexture[index] && !replace)
+            return;
+        textures[index] = texture;
+        hasTexture[index] = true;
+    }
+
+    void rebuild()
+    {
+        bindings.clear();
+        diffuseLayer = -1;
+        for (size_t i = 0; i < NUM_SLOTS; ++i)
+        {
+            if (!hasTexture[i])
+                continue;
+            const Texture2D& texture = textures[i].texture;
+            bool layered = texture.Target == GL_TEXTURE_2D_ARRAY;
+            bindings.push_back({ layered ? ARRAY_TEXTURE_UNIT : unitFor(textures[i].slot), texture.Target, texture.ID,
+                SamplerCache::GetInstance().Get(texture.GetParams()) });
+            if (layered)
+                diffuseLayer = texture.Layer;
+        }
+
+        const Texture* diffuse = GetTexture(TextureSlot::Diffuse);
+        uint64_t textureKey = diffuse ? diffuse->texture.ID : 0;
+        uint64_t layerKey = static_cast<uint64_t>(diffuseLayer + 1) & 0xFFFF;
+        sortKey = (textureKey << 32) | (layerKey << 16) | (id & 0xFFFF);
+    }
+};
@@ -1,11 +1,16 @@
 #pragma once
 
+#include "gl_state.hpp"
+#include "gpu_memory.hpp"
+#include "material.hpp"
 #include "shader.hpp"
-#include "texture_2D.hpp"
 
 #include <glad/gl.h>
 #include <glm/glm.hpp>
 
+#include <cmath>
+#include <memory>
+#include <string>
 #include <vector>
 
 struct Vertex
@@ -17,53 +22,125 @@ struct Vertex
     glm::vec4 BoneWeights;
 };
 
-struct Texture
-{
-    Texture2D texture;
-    std::string type;
-    std::string path;
-};
-
 class Mesh
 {
 public:
-    Mesh(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices, const std::vector<Texture>& textures)
-        : vertices(vertices), indices(indices), textures(textures), VAO(0), VBO(0), EBO(0)
+    // The asset name is what the buffers' GPU memory is accounted to
+    Mesh(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices, std::shared_ptr<const Material> material,
+        const std::string& asset = "mesh")
+        : vertices(vertices), indices(indices), material(std::move(material)), VAO(0), VBO(0), EBO(0)
     {
-        setupBuffers();
+        setupBuffers(asset);
+        uvDensity = calcUVDensity();
     }
 
     void Draw(const Shader& shader) const
     {
         shader.Use();
-        bindTextures(shader);
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-        glActiveTexture(GL_TEXTURE0);
+        material->Bind(shader);
+        GLState& glState = GLState::GetInstance();
+        glState.BindVertexArray(VAO);
+        glState.DrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, 0);
+    }
+
+    // Per-instance data comes from the shader, e.g. indexed by gl_InstanceID
+    void DrawInstanced(const Shader& shader, GLsizei instances) const
+    {
+        shader.Use();
+        material->Bind(shader);
+        GLState& glState = GLState::GetInstance();
+        glState.BindVertexArray(VAO);
+        glState.DrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, 0, instances);
+    }
+
+    // Same, through a vertex array from CreateInstancedVertexArray
+    void DrawInstanced(const Shader& shader, GLsizei instances, GLuint vertexArray) const
+    {
+        shader.Use();
+        material->Bind(shader);
+        GLState& glState = GLState::GetInstance();
+        glState.BindVertexArray(vertexArray);
+        glState.DrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, 0, instances);
+    }
+
+    // A vertex array over this mesh's buffers that also reads a model matrix per instance from
+    // instanceBuffer, at attributes 5-8; every instanced batch of the mesh gets its own
+    GLuint CreateInstancedVertexArray(GLuint instanceBuffer) const
+    {
+        GLuint vertexArray;
+        glGenVertexArrays(1, &vertexArray);
+        GLState& glState = GLState::GetInstance();
+        glState.BindVertexArray(vertexArray);
+        glState.BindBuffer(GL_ARRAY_BUFFER, VBO);
+        glState.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        setupAttributes();
+
+        glState.BindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        for (GLuint column = 0; column < 4; ++column)
+        {
+            glEnableVertexAttribArray(INSTANCE_MATRIX_ATTRIBUTE + column);
+            glVertexAttribPointer(INSTANCE_MATRIX_ATTRIBUTE + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(column * sizeof(glm::vec4)));
+            glVertexAttribDivisor(INSTANCE_MATRIX_ATTRIBUTE + column, 1);
+        }
+        glState.BindVertexArray(0);
+        return vertexArray;
+    }
+
+    // Frees the GL objects. Copies share them, so only for meshes with a single owner, e.g. streamed ground chunks
+    void Release()
+    {
+        GpuMemory& gpuMemory = GpuMemory::GetInstance();
+        gpuMemory.ReleaseBuffer(VBO);
+        gpuMemory.ReleaseBuffer(EBO);
+        GLState& glState = GLState::GetInstance();
+        glState.DeleteVertexArray(VAO);
+        glState.DeleteBuffer(VBO);
+        glState.DeleteBuffer(EBO);
+        VAO = VBO = EBO = 0;
     }
 
-    void AddTexture(Texture texture)
+    void SetMaterial(std::shared_ptr<const Material> newMaterial)
     {
-        textures.push_back(texture);
+        material = std::move(newMaterial);
     }
 
-    std::vector<Texture> GetTextures() const { return textures; }
+    const Material& GetMaterial() const { return *material; }
+
+    // UV units per object-space unit, averaged over the surface; 0 without usable UVs
+    float GetUVDensity() const { return uvDensity; }
 
     void Debug() const
     {
-        std::cout << "Vertices: " << vertices.size() << ", Indices: " << indices.size() << ", Textures: " << textures.size() << std::endl;
-        for (const auto& texture : textures)
-            std::cout << "Texture: " << texture.path << ", type: " << texture.type << std::endl;
+        std::cout << "Vertices: " << vertices.size() << ", Indices: " << indices.size() << std::endl;
+        material->Debug();
     }
 
 private:
+    static constexpr GLuint INSTANCE_MATRIX_ATTRIBUTE = 5; // Matches default.vs
+
     GLuint VAO, VBO, EBO; // Vertex Array Object, Vertex Buffer Object, Element Buffer Object
     std::vector<Vertex> vertices;
     std::vector<GLuint> indices;
-    std::vector<Texture> textures;
+    std::shared_ptr<const Material> material;
+    float uvDensity = 0.0f;
+
+    // Square root of the UV area over the surface area, so tiling and atlas islands count for what they cover
+    float calcUVDensity() const
+    {
+        double surfaceArea = 0.0, uvArea = 0.0;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            const Vertex& a = vertices[indices[i]];
+            const Vertex& b = vertices[indices[i + 1]];
+            const Vertex& c = vertices[indices[i + 2]];
+            surfaceArea += glm::length(glm::cross(b.Position - a.Position, c.Position - a.Position));
+            glm::vec2 uvB = b.TexCoords - a.TexCoords, uvC = c.TexCoords - a.TexCoords;
+            uvArea += std::abs(uvB.x * uvC.y - uvB.y * uvC.x);
+        }
+        return surfaceArea > 0.0 ? static_cast<float>(std::sqrt(uvArea / surfaceArea)) : 0.0f;
+    }
 
-    void setupBuffers()
+    void setupBuffers(const std::string& asset)
     {
         // Generate buffers and arrays
         glGenVertexArrays(1, &VAO);
@@ -71,17 +148,28 @@ private:
         glGenBuffers(1, &EBO);
 
         // Bind VAO
-        glBindVertexArray(VAO);
+        GLState& glState = GLState::GetInstance();
+        glState.BindVertexArray(VAO);
 
         // Vertex Buffer Object
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glState.BindBuffer(GL_ARRAY_BUFFER, VBO);
         glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
 
         // Element Buffer Object
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glState.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+        GpuMemory& gpuMemory = GpuMemory::GetInstance();
+        gpuMemory.TrackBuffer(VBO, vertices.size() * sizeof(Vertex), GpuMemoryCategory::Vertex, asset);
+        gpuMemory.TrackBuffer(EBO, indices.size() * sizeof(GLuint), GpuMemoryCategory::Index, asset);
+        setupAttributes();
+
+        // Unbind VAO to prevent accidental modifications
+        glState.BindVertexArray(0);
+    }
 
-        // Vertex attributes
+    // Vertex attributes of the bound vertex array, read from the bound array buffer
+    void setupAttributes() const
+    {
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Position));
 
@@ -96,33 +184,5 @@ private:
 
         glEnableVertexAttribArray(4);
         glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, BoneWeights));
-
-        // Unbind VAO to prevent accidental modifications
-        glBindVertexArray(0);
-    }
-
-    void bindTextures(const Shader& shader) const
-    {
-        GLuint diffuseCount = 0;
-        GLuint specularCount = 0;
-        GLuint normalCount = 0;
-
-        for (size_t i = 0; i < textures.size(); ++i)
-        {
-            glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(i));
-            // Determine the uniform name based on the type
-            std::string uniformName;
-            if (textures[i].type == "texture_diffuse")
-                uniformName = "texture_diffuse" + std::to_string(diffuseCount++);
-            else if (textures[i].type == "texture_specular")
-                uniformName = "texture_specular" + std::to_string(specularCount++);
-            else if (textures[i].type == "texture_normal")
-                uniformName = "texture_normal" + std::to_string(normalCount++);
-            else
-                uniformName = textures[i].type; // Fallback for custom types
-
-            shader.SetInt(uniformName, static_cast<int>(i));
-            textures[i].texture.Bind();
-        }
     }
 };
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "animated_model.hpp"
+#include "skinned_model.hpp"
+#include "texture_streamer.hpp"
 
 #include "ozz/animation/offline/raw_animation.h"
 #include "ozz/animation/offline/raw_skeleton.h"
@@ -14,7 +16,9 @@
 
 #include <iostream>
 #include <functional>
+#include <exception>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -51,10 +55,34 @@ public:
         return ozzTransform;
     }
 
+    // Route model textures through the streamer instead of uploading all their mips
+    void SetTextureStreamer(TextureStreamer* streamer) { textureStreamer = streamer; }
+
+    // Loads an animated asset into the runtime chosen for it, both import at GLOBAL_SCALE
+    // Returns nullptr on failure with either backend; import errors are logged rather than thrown
+    std::unique_ptr<AnimationRuntime> LoadAnimated(const std::string& path, AnimationBackend backend)
+    {
+        try
+        {
+            if (backend == AnimationBackend::Assimp)
+                return std::make_unique<SkinnedModel>(path, GLOBAL_SCALE);
+
+            auto model = std::make_unique<AnimatedModel>();
+            if (!LoadFromFile(path, *model))
+                return nullptr;
+            return model;
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "ERROR::MODELLOADER: Failed to load \"" << path << "\": " << e.what() << std::endl;
+            return nullptr;
+        }
+    }
+
     bool LoadFromFile(const std::string& path, AnimatedModel& model)
     {
         Assimp::Importer importer;
-        importer.SetPropertyFloat(AI_CONFIG_GLOBAL_SCALE_FACTOR_KEY, 0.01f);
+        importer.SetPropertyFloat(AI_CONFIG_GLOBAL_SCALE_FACTOR_KEY, GLOBAL_SCALE);
         const aiScene* pScene = importer.ReadFile(path,
             aiProcessPreset_TargetRealtime_Fast | aiProcess_GlobalScale | aiProcess_LimitBoneWeights | aiProcess_FlipUVs);
 
@@ -62,6 +90,7 @@ public:
             throw std::runtime_error("ERROR::ASSIMP: " + std::string(importer.GetErrorString()));
 
         directory = path.substr(0, path.find_last_of("/"));
+        modelPath = path;
 
         std::vector<Joint> joints;
         std::map<std::string, int> boneMap;
@@ -91,12 +120,15 @@ public:
     }
 
 private:
+    static constexpr float GLOBAL_SCALE = 0.01f;
     unsigned int MAX_BONE_INFLUENCE = 4;
     std::string directory;
+    std::string modelPath; // Asset the meshes' GPU memory is accounted to
     std::vector<Texture> cachedTextures;
+    TextureStreamer* textureStreamer;
 
     // Private constructor to prevent external instantiation
-    ModelLoader() {}
+    ModelLoader() : textureStreamer(nullptr) {}
     // Delete copy constructor and assignment operator to prevent copying
     ModelLoader(const ModelLoader&) = delete;
     ModelLoader& operator=(const ModelLoader&) = delete;
@@ -158,6 +190,8 @@ private:
             return false;
         }
 
+        // Events follow the clips that make it into the model
+        std::vector<ClipEvents> sceneEvents = ClipEvents::FromScene(scene), events;
         for (unsigned int animIndex = 0; animIndex < scene->mNumAnimations; ++animIndex)
         {
             aiAnimation* aiAnim = scene->mAnimations[animIndex];
@@ -220,13 +254,16 @@ private:
 
             ozz::animation::offline::AnimationBuilder animBuilder;
             model.AddAnimation(std::move(animBuilder(rawAnimation)));
+            events.push_back(std::move(sceneEvents[animIndex]));
         }
+        model.SetClipEvents(std::move(events));
 
         return true;
     }
 
     bool ExtractMeshes(const aiScene* scene, std::vector<Joint>& joints, std::map<std::string, int>& boneMap, AnimatedModel& model)
     {
+        std::map<unsigned int, std::shared_ptr<Material>> materials;
         for (unsigned int i = 0; i < scene->mNumMeshes; ++i)
         {
             const aiMesh* mesh = scene->mMeshes[i];
@@ -291,20 +328,22 @@ private:
                     indices.emplace_back(face.mIndices[j]);
             }
 
-            // Process textures
-            if (mesh->mMaterialIndex >= 0)
+            // Process materials, shared between meshes using the same one
+            auto& material = materials[mesh->mMaterialIndex];
+            if (!material)
             {
-                aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+                aiMaterial* aiMat = scene->mMaterials[mesh->mMaterialIndex];
 
-                auto diffuseTextures = ExtractTextures(scene, material, aiTextureType_DIFFUSE, "texture_diffuse");
+                auto diffuseTextures = ExtractTextures(scene, aiMat, aiTextureType_DIFFUSE, TextureSlot::Diffuse);
                 textures.insert(textures.end(), diffuseTextures.begin(), diffuseTextures.end());
-                auto specularTextures = ExtractTextures(scene, material, aiTextureType_SPECULAR, "texture_specular");
+                auto specularTextures = ExtractTextures(scene, aiMat, aiTextureType_SPECULAR, TextureSlot::Specular);
                 textures.insert(textures.end(), specularTextures.begin(), specularTextures.end());
-                auto normalTextures = ExtractTextures(scene, material, aiTextureType_HEIGHT, "texture_normal");
+                auto normalTextures = ExtractTextures(scene, aiMat, aiTextureType_HEIGHT, TextureSlot::Normal);
                 textures.insert(textures.end(), normalTextures.begin(), normalTextures.end());
+                material = std::make_shared<Material>(textures);
             }
 
-            model.AddMesh({ std::move(vertices), std::move(indices), std::move(textures) });
+            model.AddMesh({ std::move(vertices), std::move(indices), material, modelPath });
             model.SetJoints(joints);
         }
 
@@ -336,7 +375,7 @@ private:
             ExtractJoints(node->mChildren[i], jointIndex, joints, boneMap);
     }
 
-    std::vector<Texture> ExtractTextures(const aiScene* scene, aiMaterial* material, aiTextureType textureType, const std::string& typeName)
+    std::vector<Texture> ExtractTextures(const aiScene* scene, aiMaterial* material, aiTextureType textureType, TextureSlot slot)
     {
         std::vector<Texture> textures;
         for (unsigned int i = 0; i < material->GetTextureCount(textureType); ++i)
@@ -351,6 +390,7 @@ private:
                 if (std::strcmp(cachedTextures[j].path.data(), textureFilename.C_Str()) == 0)
                 {
                     textures.emplace_back(cachedTextures[j]);
+                    textures.back().slot = slot;
                     skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
                     break;
                 }
@@ -359,12 +399,19 @@ private:
             if (!skip) // if texture hasn't been loaded already, load it
             {
                 Texture2D texture2D;
-                if (const auto& texture = scene->GetEmbeddedTexture(textureFilename.C_Str()))
-                    texture2D = Texture2D(reinterpret_cast<unsigned char*>(texture->pcData), texture->mWidth, texture->mHeight);
+                const auto& texture = scene->GetEmbeddedTexture(textureFilename.C_Str());
+                std::string texturePath = directory + "/" + std::string(textureFilename.C_Str());
+                TextureParams params{ .srgb = slot == TextureSlot::Diffuse };
+                if (textureStreamer && texture)
+                    texture2D = textureStreamer->Load(reinterpret_cast<unsigned char*>(texture->pcData), texture->mWidth, texture->mHeight, params, texturePath);
+                else if (textureStreamer)
+                    texture2D = textureStreamer->Load(texturePath, params);
+                else if (texture)
+                    texture2D = Texture2D(reinterpret_cast<unsigned char*>(texture->pcData), texture->mWidth, texture->mHeight, params, texturePath);
                 else
-                    texture2D = Texture2D(std::string(directory + "/" + std::string(textureFilename.C_Str())));
+                    texture2D = Texture2D(texturePath, params);
 
-                Texture tex = { texture2D, typeName, std::string(textureFilename.C_Str()) };
+                Texture tex = { texture2D, slot, std::string(textureFilename.C_Str()) };
                 textures.push_back(tex);
                 cachedTextures.push_back(tex);
             }
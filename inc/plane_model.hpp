@@ -1,6 +1,7 @@
 #pragma once
 
 #include "basic_model.hpp"
+#include "texture_array.hpp"
 
 #include <string>
 #include <vector>
@@ -39,10 +40,10 @@ private:
 
         // Texture setup
         std::vector<Texture> textures = {
-            { Texture2D(texturePath, { .wrapS = GL_REPEAT, .wrapT = GL_REPEAT }), "texture_diffuse", texturePath }
+            { TextureArrayPool::GetInstance().Load(texturePath, { .wrapS = GL_REPEAT, .wrapT = GL_REPEAT }), TextureSlot::Diffuse, texturePath }
         };
 
         // Create the mesh
-        AddMesh({ vertices, indices, textures });
+        AddMesh({ vertices, indices, std::make_shared<Material>(textures), "plane" });
     }
 };
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+enum class PlaybackMode
+{
+    Loop,  // Wraps to the start of the clip
+    Clamp  // Holds the last pose
+};
+
+// Playback position of one animation instance. Elapsed time is kept in double seconds and the clip
+// time is derived from it on every query instead of being accumulated and wrapped in float, so long
+// sessions do not drift and the same sequence of Advance calls always yields the same poses.
+class PlaybackClock
+{
+public:
+    double Rate = 1.0;  // Playback speed, negative plays backwards
+    double Phase = 0.0; // Offset as a fraction of the clip, e.g. to keep a crowd out of lockstep
+    PlaybackMode Mode = PlaybackMode::Loop;
+
+    void Advance(double deltaTime) { elapsed += deltaTime * Rate; }
+    void Reset() { elapsed = 0.0; }
+
+    // Elapsed playback time, scaled by the rate; setting it restores a recorded state
+    double GetElapsed() const { return elapsed; }
+    void SetElapsed(double time) { elapsed = time; }
+
+    // Position within a clip of the given duration, in seconds
+    double GetClipTime(double duration) const
+    {
+        if (duration <= 0.0)
+            return 0.0;
+        double time = elapsed + Phase * duration;
+        if (Mode == PlaybackMode::Clamp)
+            return std::clamp(time, 0.0, duration);
+        time = std::fmod(time, duration);
+        return time < 0.0 ? time + duration : time;
+    }
+
+private:
+    double elapsed = 0.0;
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "bone_palette.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Poses of one model keyed by clip and quantized time. Instances that play the same clip at nearly the
+// same time, e.g. a marching crowd, copy an already computed pose instead of sampling and converting
+// to model space again. Quantization snaps sample times to a fixed rate, trading temporal resolution
+// for hits; a rate of 0 disables the cache.
+class PoseCache
+{
+public:
+    struct Stats
+    {
+        size_t Lookups = 0;
+        size_t Hits = 0;
+    };
+
+    struct Pose
+    {
+        BonePalette Palette;
+        std::vector<glm::mat4> ModelSpace;
+    };
+
+    // Sample times are snapped to multiples of 1 / samplesPerSecond
+    void SetQuantization(float samplesPerSecond)
+    {
+        rate = samplesPerSecond;
+        entries.clear();
+    }
+
+    bool IsEnabled() const { return rate > 0.0f; }
+
+    // Time the pose for this bucket is sampled at, clamped to the clip
+    float Quantize(float timeInSeconds, float duration) const
+    {
+        return std::fmin(std::round(timeInSeconds * rate) / rate, duration);
+    }
+
+    const Pose* Find(unsigned int clip, float quantizedTime)
+    {
+        ++stats.Lookups;
+        auto it = entries.find(key(clip, quantizedTime));
+        if (it == entries.end())
+            return nullptr;
+        ++stats.Hits;
+        return &it->second;
+    }
+
+    void Store(unsigned int clip, float quantizedTime, const BonePalette& palette, const std::vector<glm::mat4>& modelSpace)
+    {
+        // Bounded by forgetting everything, a crowd refills the buckets it uses within a frame
+        if (entries.size() >= maxEntries)
+            entries.clear();
+        Pose& pose = entries[key(clip, quantizedTime)];
+        pose.Palette = palette;
+        pose.ModelSpace = modelSpace;
+    }
+
+    void Clear() { entries.clear(); }
+
+    // Lookups and hits since the last call
+    Stats EndInterval()
+    {
+        Stats interval = stats;
+        stats = {};
+        return interval;
+    }
+
+private:
+    float rate = 0.0f;
+    size_t maxEntries = 1024;
+    std::unordered_map<uint64_t, Pose> entries;
+    Stats stats;
+
+    uint64_t key(unsigned int clip, float quantizedTime) const
+    {
+        return (static_cast<uint64_t>(clip) << 32) | static_cast<uint32_t>(std::lround(quantizedTime * rate));
+    }
+};
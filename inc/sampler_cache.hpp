@@ -0,0 +1,107 @@
+#pragma once
+
+#include "texture_2D.hpp"
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <vector>
+
+// Core since 4.6, available everywhere as EXT/ARB_texture_filter_anisotropic with the same values
+#ifndef GL_TEXTURE_MAX_ANISOTROPY
+#define GL_TEXTURE_MAX_ANISOTROPY 0x84FE
+#endif
+#ifndef GL_MAX_TEXTURE_MAX_ANISOTROPY
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY 0x84FF
+#endif
+
+enum class FilterQuality
+{
+    Low,    // No anisotropic filtering
+    Medium, // 4x
+    High    // 16x, clamped to the driver maximum
+};
+
+// Shared GL sampler objects, one per unique sampling state. Textures no longer carry wrap/filter state,
+// so the same texture can be sampled differently and a quality change only touches the samplers.
+class SamplerCache
+{
+public:
+    static SamplerCache& GetInstance()
+    {
+        static SamplerCache instance;
+        return instance;
+    }
+
+    // Must be called with a current GL context before the first Get
+    void Init()
+    {
+        GLfloat supported = 1.0f;
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &supported);
+        if (glGetError() != GL_NO_ERROR)
+            supported = 1.0f;
+        maxAnisotropy = supported;
+    }
+
+    GLuint Get(const TextureParams& params)
+    {
+        for (const auto& entry : samplers)
+            if (entry.params.wrapS == params.wrapS && entry.params.wrapT == params.wrapT
+                && entry.params.filterMin == params.filterMin && entry.params.filterMax == params.filterMax)
+                return entry.ID;
+
+        Entry entry = { 0, params };
+        glGenSamplers(1, &entry.ID);
+        glSamplerParameteri(entry.ID, GL_TEXTURE_WRAP_S, params.wrapS);
+        glSamplerParameteri(entry.ID, GL_TEXTURE_WRAP_T, params.wrapT);
+        glSamplerParameteri(entry.ID, GL_TEXTURE_MIN_FILTER, params.filterMin);
+        glSamplerParameteri(entry.ID, GL_TEXTURE_MAG_FILTER, params.filterMax);
+        applyAnisotropy(entry);
+        samplers.push_back(entry);
+        return entry.ID;
+    }
+
+    void SetQuality(FilterQuality preset)
+    {
+        quality = preset;
+        for (const auto& entry : samplers)
+            applyAnisotropy(entry);
+    }
+
+    FilterQuality GetQuality() const { return quality; }
+    float GetAnisotropy() const { return anisotropyFor(quality); }
+    size_t GetNumSamplers() const { return samplers.size(); }
+
+private:
+    struct Entry
+    {
+        GLuint ID;
+        TextureParams params;
+    };
+
+    std::vector<Entry> samplers;
+    FilterQuality quality;
+    float maxAnisotropy;
+
+    SamplerCache() : quality(FilterQuality::High), maxAnisotropy(1.0f) {}
+    SamplerCache(const SamplerCache&) = delete;
+    SamplerCache& operator=(const SamplerCache&) = delete;
+
+    float anisotropyFor(FilterQuality preset) const
+    {
+        switch (preset)
+        {
+        case FilterQuality::Medium: return std::min(4.0f, maxAnisotropy);
+        case FilterQuality::High:   return std::min(16.0f, maxAnisotropy);
+        default:                    return 1.0f;
+        }
+    }
+
+    void applyAnisotropy(const Entry& entry) const
+    {
+        // Anisotropy only affects minification with mipmaps
+        bool mipmapped = entry.params.filterMin != GL_NEAREST && entry.params.filterMin != GL_LINEAR;
+        if (maxAnisotropy > 1.0f)
+            glSamplerParameterf(entry.ID, GL_TEXTURE_MAX_ANISOTROPY, mipmapped ? anisotropyFor(quality) : 1.0f);
+    }
+};
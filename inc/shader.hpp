@@ -1,5 +1,8 @@
 #pragma once
 
+#include "gl_recorder.hpp"
+#include "gl_state.hpp"
+
 #include <glad/gl.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -15,6 +18,7 @@ class Shader
 {
 public:
     GLuint ID;
+    mutable unsigned int CurrentMaterial = 0; // Material whose uniforms are set on this program, see Material::Bind
 
     Shader(const std::string& vertexPath, const std::string& fragmentPath, const std::string& geometryPath = "")
     {
@@ -63,7 +67,7 @@ public:
     // Use the shader program
     void Use() const
     {
-        glUseProgram(ID);
+        GLState::GetInstance().UseProgram(ID);
     }
 
     // Setters for uniforms
@@ -76,10 +80,12 @@ public:
     void SetMat2(const std::string& name, const glm::mat2& mat) const { setUniform(name, mat); }
     void SetMat3(const std::string& name, const glm::mat3& mat) const { setUniform(name, mat); }
     void SetMat4(const std::string& name, const glm::mat4& mat) const { setUniform(name, mat); }
-    void SetMat4v(const std::string& name, std::vector<glm::mat4>& matrices) const { setUniform(name, matrices); }
+    void SetMat4v(const std::string& name, const std::vector<glm::mat4>& matrices) const { setUniform(name, matrices); }
 
 private:
     mutable std::unordered_map<std::string, GLint> uniformLocations;
+    // Last value of int/bool uniforms, e.g. "animated" which every model sets before drawing
+    mutable std::unordered_map<GLint, int> intValues;
 
     // Function to read file into a string
     std::string readFile(const std::string& path)
@@ -124,16 +130,39 @@ private:
     }
 
     // Template specialization for uniform setting based on type
-    void setUniformImpl(GLint location, bool value) const { glUniform1i(location, value); }
-    void setUniformImpl(GLint location, int value) const { glUniform1i(location, value); }
-    void setUniformImpl(GLint location, float value) const { glUniform1f(location, value); }
-    void setUniformImpl(GLint location, const glm::vec2& value) const { glUniform2fv(location, 1, glm::value_ptr(value)); }
-    void setUniformImpl(GLint location, const glm::vec3& value) const { glUniform3fv(location, 1, glm::value_ptr(value)); }
-    void setUniformImpl(GLint location, const glm::vec4& value) const { glUniform4fv(location, 1, glm::value_ptr(value)); }
-    void setUniformImpl(GLint location, const glm::mat2& mat) const { glUniformMatrix2fv(location, 1, GL_FALSE, glm::value_ptr(mat)); }
-    void setUniformImpl(GLint location, const glm::mat3& mat) const { glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(mat)); }
-    void setUniformImpl(GLint location, const glm::mat4& mat) const { glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(mat)); }
-    void setUniformImpl(GLint location, const std::vector<glm::mat4>& matrices) const { glUniformMatrix4fv(location, (GLsizei)matrices.size(), GL_FALSE, glm::value_ptr(matrices[0])); }
+    void setUniformImpl(GLint location, bool value) const { setUniformImpl(location, static_cast<int>(value)); }
+    void setUniformImpl(GLint location, int value) const
+    {
+        // While recording every set is issued, so the capture does not depend on earlier frames
+        GLRecorder& recorder = GLRecorder::GetInstance();
+        auto it = intValues.find(location);
+        bool issue = recorder.IsRecording() || it == intValues.end() || it->second != value;
+        GLState::GetInstance().CountCall(issue);
+        if (!issue)
+            return;
+        glUniform1i(location, value);
+        intValues[location] = value;
+        record(location, GLUniformType::Int, 1, &value);
+    }
+    void setUniformImpl(GLint location, float value) const { glUniform1f(location, value); record(location, GLUniformType::Float, 1, &value); }
+    void setUniformImpl(GLint location, const glm::vec2& value) const { glUniform2fv(location, 1, glm::value_ptr(value)); record(location, GLUniformType::Vec2, 1, glm::value_ptr(value)); }
+    void setUniformImpl(GLint location, const glm::vec3& value) const { glUniform3fv(location, 1, glm::value_ptr(value)); record(location, GLUniformType::Vec3, 1, glm::value_ptr(value)); }
+    void setUniformImpl(GLint location, const glm::vec4& value) const { glUniform4fv(location, 1, glm::value_ptr(value)); record(location, GLUniformType::Vec4, 1, glm::value_ptr(value)); }
+    void setUniformImpl(GLint location, const glm::mat2& mat) const { glUniformMatrix2fv(location, 1, GL_FALSE, glm::value_ptr(mat)); record(location, GLUniformType::Mat2, 1, glm::value_ptr(mat)); }
+    void setUniformImpl(GLint location, const glm::mat3& mat) const { glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(mat)); record(location, GLUniformType::Mat3, 1, glm::value_ptr(mat)); }
+    void setUniformImpl(GLint location, const glm::mat4& mat) const { glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(mat)); record(location, GLUniformType::Mat4, 1, glm::value_ptr(mat)); }
+    void setUniformImpl(GLint location, const std::vector<glm::mat4>& matrices) const
+    {
+        glUniformMatrix4fv(location, (GLsizei)matrices.size(), GL_FALSE, glm::value_ptr(matrices[0]));
+        record(location, GLUniformType::Mat4, (GLsizei)matrices.size(), glm::value_ptr(matrices[0]));
+    }
+
+    static void record(GLint location, GLUniformType type, GLsizei count, const void* data)
+    {
+        GLRecorder& recorder = GLRecorder::GetInstance();
+        if (recorder.IsRecording())
+            recorder.Uniform(location, type, count, data);
+    }
 
     // Utility function to check compile/link errors
     void checkCompileErrors(GLuint shader, const std::string& type) const
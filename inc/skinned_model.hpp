@@ -1,6 +1,6 @@
 #pragma once
 
-#include "basic_model.hpp"
+#include "animation_runtime.hpp"
 
 #include <glad/gl.h>
 #include <glm/glm.hpp>
@@ -15,6 +15,7 @@
 
 #include <iostream>
 #include <map>
+#include <memory>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -33,18 +34,14 @@ static inline glm::mat4 GetGLMMat4(const aiMatrix4x4& from)
 static inline glm::vec3 GetGLMVec3(const aiVector3D& vec) { return glm::vec3(vec.x, vec.y, vec.z); }
 static inline glm::quat GetGLMQuat(const aiQuaternion& qat) { return glm::quat(qat.w, qat.x, qat.y, qat.z); }
 
-class SkinnedModel : public BasicModel
+class SkinnedModel : public AnimationRuntime
 {
 public:
-    SkinnedModel(const std::string& path)
-        : animDuration(0.0f), currentAnimation(0), bonesCount(0)
+    // scale is applied by Assimp at import, e.g. to match assets loaded through ModelLoader
+    SkinnedModel(const std::string& path, float scale = 1.0f)
+        : scene(nullptr), animDuration(0.0f), currentAnimation(0), bonesCount(0)
     {
-        loadModel(path);
-    }
-
-    ~SkinnedModel()
-    {
-        scene = nullptr;
+        loadModel(path, scale);
     }
 
     void Draw(const Shader& shader) const override
@@ -55,29 +52,53 @@ public:
 
     void TextureOverride(const std::string& texturePath)
     {
+        Texture2D texture(texturePath);
         for (auto& mesh : meshes)
-            mesh.AddTexture({ Texture2D(texturePath), "texture_diffuse", texturePath });
+        {
+            auto material = std::make_shared<Material>(mesh.GetMaterial());
+            material->SetTexture({ texture, TextureSlot::Diffuse, texturePath });
+            mesh.SetMaterial(material);
+        }
     }
 
-    void SetCurrentAnimation(unsigned int animation)
+    const char* GetBackendName() const override { return "Assimp"; }
+
+    unsigned int GetNumAnimations() const override { return numAnimations; }
+
+    void SetCurrentAnimation(unsigned int animation) override
     {
-        if (hasAnimations && animation >= 0 && animation < numAnimations)
+        if (hasAnimations && animation < numAnimations)
         {
             currentAnimation = animation;
             setAnimParams();
         }
     }
 
-    void SetBoneTransformations(Shader shader, float currentTime)
+    unsigned int GetCurrentAnimation() const override { return currentAnimation; }
+
+    float GetDuration() const override { return hasAnimations ? animDuration / ticksPerSecond : 0.0f; }
+
+    void Sample(float timeInSeconds) override
     {
         if (hasAnimations)
+            boneTransform(timeInSeconds);
+    }
+
+    unsigned int GetNumJoints() const override { return bonesCount; }
+    const std::string& GetJointName(unsigned int index) const override { return boneNames[index]; }
+
+    size_t GetAnimationBytes() const override
+    {
+        size_t bytes = nodes.size() * sizeof(FlatNode);
+        for (const Clip& clip : clips)
         {
-            std::vector<glm::mat4> transforms;
-            boneTransform(currentTime, transforms);
-            shader.Use();
-            shader.SetBool("animated", hasAnimations);
-            shader.SetMat4v("finalBonesMatrices", transforms);
+            bytes += clip.nodeChannels.size() * sizeof(int);
+            for (const Channel& channel : clip.channels)
+                bytes += (channel.positionTimes.size() + channel.rotationTimes.size() + channel.scalingTimes.size()) * sizeof(float)
+                    + (channel.positions.size() + channel.scales.size()) * sizeof(glm::vec3)
+                    + channel.rotations.size() * sizeof(glm::quat);
         }
+        return bytes;
     }
 
     void Debug()
@@ -92,43 +113,63 @@ public:
                   << std::endl;
 
         for (const auto& mesh : meshes)
-            for (const auto& texture : mesh.GetTextures())
-                std::cout << "Texture: " << texture.path << ", type: " << texture.type << std::endl;
+            mesh.GetMaterial().Debug();
 
-        for (unsigned int i = 0; i < numAnimations; ++i)
-        {
-            aiAnimation* animation = scene->mAnimations[i];
-            std::cout << "Animation: " << animation->mName.C_Str()
-                      << ", Duration: " << animation->mDuration
-                      << ", TicksPerSecond: " << animation->mTicksPerSecond  << std::endl;
-        }
+        for (const Clip& clip : clips)
+            std::cout << "Animation: " << clip.name
+                      << ", Duration: " << clip.duration
+                      << ", TicksPerSecond: " << clip.ticksPerSecond
+                      << ", Channels: " << clip.channels.size() << std::endl;
     }
 
-    bool HasAnimations() { return hasAnimations; }
-    unsigned int GetNumAnimations() { return numAnimations; }
-
 private:
-    #define MAX_BONE_INFLUENCE 4
+    static constexpr unsigned int MAX_BONE_INFLUENCE = 4;
 
-    struct BoneMatrix
+    // Node of the flattened hierarchy; bone is -1 for nodes that do not deform the mesh
+    struct FlatNode
     {
-        glm::mat4 BoneOffset;
-        glm::mat4 FinalTransformation;
+        int parent;
+        int bone;
+        glm::mat4 transformation;
+    };
 
-        BoneMatrix()
-        {
-            BoneOffset = glm::mat4(0.0f);
-            FinalTransformation = glm::mat4(0.0f);
-        }
+    // Keys of one animated node, with times and values in separate arrays so the cursor search
+    // only touches the times
+    struct Channel
+    {
+        std::vector<float> positionTimes;
+        std::vector<glm::vec3> positions;
+        std::vector<float> rotationTimes;
+        std::vector<glm::quat> rotations;
+        std::vector<float> scalingTimes;
+        std::vector<glm::vec3> scales;
+    };
+
+    struct Clip
+    {
+        std::string name;
+        float duration;
+        float ticksPerSecond;
+        std::vector<Channel> channels;
+        std::vector<int> nodeChannels; // Channel per flattened node, -1 if not animated
+    };
+
+    // Last key segment used per channel, the next sample starts searching from there
+    struct KeyCursor
+    {
+        unsigned int position = 0;
+        unsigned int rotation = 0;
+        unsigned int scaling = 0;
     };
 
     std::string path;
-    Assimp::Importer importer;
-    const aiScene* scene;
+    const aiScene* scene; // Only valid while loading, everything sampled at runtime is baked into clips and nodes
     std::string directory;
     std::vector<Texture> loadedTextures;
+    std::map<unsigned int, std::shared_ptr<Material>> loadedMaterials;
     std::map<std::string, unsigned int> boneMapping;
-    std::vector<BoneMatrix> boneMatrices;
+    std::vector<glm::mat4> boneOffsets;
+    std::vector<std::string> boneNames;
     unsigned int bonesCount;
     glm::mat4 globalInverseTransform;
     bool hasAnimations;
@@ -136,11 +177,17 @@ private:
     unsigned int currentAnimation;
     float ticksPerSecond;
     float animDuration;
+    std::vector<FlatNode> nodes;
+    std::vector<Clip> clips;
+    std::vector<KeyCursor> cursors;
+    std::vector<glm::mat4> globalTransforms;
 
-    void loadModel(const std::string& modelPath)
+    void loadModel(const std::string& modelPath, float scale)
     {
+        Assimp::Importer importer;
+        importer.SetPropertyFloat(AI_CONFIG_GLOBAL_SCALE_FACTOR_KEY, scale);
         const aiScene* pScene = importer.ReadFile(modelPath,
-            aiProcessPreset_TargetRealtime_Fast | aiProcess_LimitBoneWeights | aiProcess_FlipUVs);
+            aiProcessPreset_TargetRealtime_Fast | aiProcess_GlobalScale | aiProcess_LimitBoneWeights | aiProcess_FlipUVs);
 
         if (!pScene || (pScene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) || !pScene->mRootNode)
             throw std::runtime_error("ERROR::ASSIMP: " + std::string(importer.GetErrorString()));
@@ -151,9 +198,17 @@ private:
         hasAnimations = scene->HasAnimations();
         numAnimations = scene->mNumAnimations;
         globalInverseTransform = glm::inverse(GetGLMMat4(scene->mRootNode->mTransformation));
-        boneMatrices.reserve(100);
         processNode(scene->mRootNode);
+        palette.Resize(bonesCount);
+        bakeAnimations();
+        SetClipEvents(ClipEvents::FromScene(scene));
         setAnimParams();
+
+        // The importer frees the scene when it goes out of scope, drop what only loading needed with it
+        scene = nullptr;
+        boneMapping.clear();
+        loadedTextures.clear();
+        loadedMaterials.clear();
     }
 
     // Process a node recursively and convert it to meshes
@@ -196,10 +251,8 @@ private:
             {
                 // allocate an index for the new bone
                 boneIndex = bonesCount;
-                BoneMatrix boneMatrix;
-                boneMatrices.push_back(boneMatrix);
-
-                boneMatrices[boneIndex].BoneOffset = GetGLMMat4(mesh->mBones[i]->mOffsetMatrix);
+                boneOffsets.push_back(GetGLMMat4(mesh->mBones[i]->mOffsetMatrix));
+                boneNames.push_back(boneName);
                 boneMapping[boneName] = boneIndex;
                 bonesCount++;
             }
@@ -231,184 +284,166 @@ private:
                 indices.emplace_back(face.mIndices[j]);
         }
 
-        // Process materials
-        if (mesh->mMaterialIndex >= 0)
+        // Process materials, shared between meshes using the same one
+        auto& material = loadedMaterials[mesh->mMaterialIndex];
+        if (!material)
         {
-            aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+            aiMaterial* aiMat = scene->mMaterials[mesh->mMaterialIndex];
 
-            auto diffuseMaps = loadMaterialTextures(scene, material, aiTextureType_DIFFUSE, "texture_diffuse");
+            auto diffuseMaps = loadMaterialTextures(scene, aiMat, aiTextureType_DIFFUSE, TextureSlot::Diffuse);
             textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
-            auto specularMaps = loadMaterialTextures(scene, material, aiTextureType_SPECULAR, "texture_specular");
+            auto specularMaps = loadMaterialTextures(scene, aiMat, aiTextureType_SPECULAR, TextureSlot::Specular);
             textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
-            auto normalMaps = loadMaterialTextures(scene, material, aiTextureType_HEIGHT, "texture_normal");
+            auto normalMaps = loadMaterialTextures(scene, aiMat, aiTextureType_HEIGHT, TextureSlot::Normal);
             textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
+            material = std::make_shared<Material>(textures);
         }
 
-        return Mesh(std::move(vertices), std::move(indices), std::move(textures));
+        return Mesh(std::move(vertices), std::move(indices), material, path);
     }
 
-    void boneTransform(float timeInSeconds, std::vector<glm::mat4>& transforms)
+    // Samples the current clip straight into the palette
+    void boneTransform(float timeInSeconds)
     {
         float timeInTicks = timeInSeconds * ticksPerSecond;
-        float animationTimeTicks = fmod(timeInTicks, animDuration);
-        readNodeHeirarchy(animationTimeTicks, scene->mRootNode, glm::mat4(1.0f));
-        transforms.resize(bonesCount);
-
-        for (unsigned int i = 0; i < bonesCount; ++i)
-            transforms[i] = boneMatrices[i].FinalTransformation;
-    }
+        float animationTimeTicks = timeInTicks > animDuration ? fmod(timeInTicks, animDuration) : timeInTicks;
+        const Clip& clip = clips[currentAnimation];
 
-    unsigned int findPosition(float animationTime, const aiNodeAnim* nodeAnim)
-    {
-        assert(nodeAnim->mNumPositionKeys > 0);
-        for (unsigned int index = 0; index < nodeAnim->mNumPositionKeys - 1; ++index)
-            if (animationTime < (float)nodeAnim->mPositionKeys[index + 1].mTime)
-                return index;
-        std::cerr << "Position animationTime is out of bound: " << animationTime << std::endl;
-        return 0;
-    }
-
-    unsigned int findRotation(float animationTime, const aiNodeAnim* nodeAnim)
-    {
-        assert(nodeAnim->mNumRotationKeys > 0);
-        for (unsigned int index = 0; index < nodeAnim->mNumRotationKeys - 1; ++index)
-            if (animationTime < (float)nodeAnim->mRotationKeys[index + 1].mTime)
-                return index;
-        std::cerr << "Rotation animationTime is out of bound: " << animationTime << std::endl;
-        return 0;
+        // Parents precede their children, so one pass in order resolves the hierarchy
+        for (size_t i = 0; i < nodes.size(); ++i)
+        {
+            const FlatNode& node = nodes[i];
+            int channel = clip.nodeChannels[i];
+            glm::mat4 nodeTransformation = channel >= 0
+                ? sampleChannel(animationTimeTicks, clip.channels[channel], cursors[channel])
+                : node.transformation;
+
+            globalTransforms[i] = node.parent >= 0 ? globalTransforms[node.parent] * nodeTransformation : nodeTransformation;
+            if (node.bone >= 0)
+                palette[node.bone] = globalInverseTransform * globalTransforms[i] * boneOffsets[node.bone];
+        }
     }
 
-    unsigned int findScaling(float animationTime, const aiNodeAnim* nodeAnim)
+    // Moves the cursor to the key segment containing animationTime and returns the interpolation factor
+    // within it. Playback mostly moves forward by less than a key per frame, so this is usually a single
+    // comparison; on a loop it restarts from 0.
+    static float advanceCursor(const std::vector<float>& times, float animationTime, unsigned int& cursor)
     {
-        assert(nodeAnim->mNumScalingKeys > 0);
-        for (unsigned int index = 0; index < nodeAnim->mNumScalingKeys - 1; ++index)
-            if (animationTime < (float)nodeAnim->mScalingKeys[index + 1].mTime)
-                return index;
-        std::cerr << "Scaling animationTime is out of bound: " << animationTime << std::endl;
-        return 0;
+        const size_t numKeys = times.size();
+        if (cursor + 1 >= numKeys || animationTime < times[cursor])
+            cursor = 0;
+        while (cursor + 2 < numKeys && animationTime >= times[cursor + 1])
+            ++cursor;
+        float deltaTime = times[cursor + 1] - times[cursor];
+        return deltaTime > 0.0f ? glm::clamp((animationTime - times[cursor]) / deltaTime, 0.0f, 1.0f) : 0.0f;
     }
 
-    void calcInterpolatedPosition(aiVector3D& out, float animationTime, const aiNodeAnim* nodeAnim)
+    glm::mat4 sampleChannel(float animationTime, const Channel& channel, KeyCursor& cursor)
     {
-        if (nodeAnim->mNumPositionKeys == 1)
+        glm::vec3 scaling = channel.scales[0];
+        if (channel.scales.size() > 1)
         {
-            out = nodeAnim->mPositionKeys[0].mValue;
-            return;
+            float factor = advanceCursor(channel.scalingTimes, animationTime, cursor.scaling);
+            scaling = glm::mix(channel.scales[cursor.scaling], channel.scales[cursor.scaling + 1], factor);
         }
 
-        unsigned int positionIndex = findPosition(animationTime, nodeAnim);
-        unsigned int nextPositionIndex = (positionIndex + 1);
-        assert(nextPositionIndex < nodeAnim->mNumPositionKeys);
-        float deltaTime = (float)(nodeAnim->mPositionKeys[nextPositionIndex].mTime - nodeAnim->mPositionKeys[positionIndex].mTime);
-        float factor = (animationTime - (float)nodeAnim->mPositionKeys[positionIndex].mTime) / deltaTime;
-        if (factor < 0.0f && factor > 1.0f)
-            std::cerr << "Factor is out of bound: " << factor << std::endl;
-        const aiVector3D& startPosition = nodeAnim->mPositionKeys[positionIndex].mValue;
-        const aiVector3D& endPosition   = nodeAnim->mPositionKeys[nextPositionIndex].mValue;
-        aiVector3D delta = endPosition - startPosition;
-        out = startPosition + factor * delta;
-    }
-
-    void calcInterpolatedRotation(aiQuaternion& out, float animationTime, const aiNodeAnim* nodeAnim)
-    {
-        if (nodeAnim->mNumRotationKeys == 1)
+        glm::quat rotation = channel.rotations[0];
+        if (channel.rotations.size() > 1)
         {
-            out = nodeAnim->mRotationKeys[0].mValue;
-            return;
+            float factor = advanceCursor(channel.rotationTimes, animationTime, cursor.rotation);
+            rotation = glm::normalize(glm::slerp(channel.rotations[cursor.rotation], channel.rotations[cursor.rotation + 1], factor));
         }
 
-        unsigned int rotationIndex = findRotation(animationTime, nodeAnim);
-        unsigned int nextRotationIndex = (rotationIndex + 1);
-        assert(nextRotationIndex < nodeAnim->mNumRotationKeys);
-        float deltaTime = (float)(nodeAnim->mRotationKeys[nextRotationIndex].mTime - nodeAnim->mRotationKeys[rotationIndex].mTime);
-        float factor = (animationTime - (float)nodeAnim->mRotationKeys[rotationIndex].mTime) / deltaTime;
-        if (factor < 0.0f && factor > 1.0f)
-            std::cerr << "Factor is out of bound: " << factor << std::endl;
-        const aiQuaternion& startRotationQ = nodeAnim->mRotationKeys[rotationIndex].mValue;
-        const aiQuaternion& endRotationQ   = nodeAnim->mRotationKeys[nextRotationIndex].mValue;
-        aiQuaternion::Interpolate(out, startRotationQ, endRotationQ, factor);
-        out = out.Normalize();
-    }
-
-    void calcInterpolatedScaling(aiVector3D& out, float animationTime, const aiNodeAnim* nodeAnim)
-    {
-        if (nodeAnim->mNumScalingKeys == 1)
+        glm::vec3 translation = channel.positions[0];
+        if (channel.positions.size() > 1)
         {
-            out = nodeAnim->mScalingKeys[0].mValue;
-            return;
+            float factor = advanceCursor(channel.positionTimes, animationTime, cursor.position);
+            translation = glm::mix(channel.positions[cursor.position], channel.positions[cursor.position + 1], factor);
         }
 
-        unsigned int scalingIndex = findScaling(animationTime, nodeAnim);
-        unsigned int nextScalingIndex = (scalingIndex + 1);
-        assert(nextScalingIndex < nodeAnim->mNumScalingKeys);
-        float deltaTime = (float)(nodeAnim->mScalingKeys[nextScalingIndex].mTime - nodeAnim->mScalingKeys[scalingIndex].mTime);
-        float factor = (animationTime - (float)nodeAnim->mScalingKeys[scalingIndex].mTime) / deltaTime;
-        if (factor < 0.0f && factor > 1.0f)
-            std::cerr << "Factor is out of bound: " << factor << std::endl;
-        const aiVector3D& startScaling = nodeAnim->mScalingKeys[scalingIndex].mValue;
-        const aiVector3D& endScaling   = nodeAnim->mScalingKeys[nextScalingIndex].mValue;
-        aiVector3D delta = endScaling - startScaling;
-        out = startScaling + factor * delta;
+        glm::mat4 scalingM = glm::scale(glm::mat4(1.0f), scaling);
+        glm::mat4 rotationM = glm::toMat4(rotation);
+        glm::mat4 translationM = glm::translate(glm::mat4(1.0f), translation);
+        return translationM * rotationM * scalingM;
     }
 
-    void readNodeHeirarchy(float animationTime, const aiNode* node, const glm::mat4& parentTransform)
+    // Copies everything sampling needs out of the scene: the node tree flattened depth-first with each
+    // node's bone resolved, and per animation its key tracks and a node-to-channel table, so sampling
+    // never compares names
+    void bakeAnimations()
     {
-        std::string nodeName(node->mName.data);
-        glm::mat4 nodeTransformation = GetGLMMat4(node->mTransformation);
-
-        const aiAnimation* animation = scene->mAnimations[currentAnimation];
-        const aiNodeAnim* nodeAnim = findNodeAnim(animation, nodeName);
-
-        if (nodeAnim)
-        {
-            aiVector3D scalingV;
-            calcInterpolatedScaling(scalingV, animationTime, nodeAnim);
-            glm::mat4 scalingM = glm::scale(glm::mat4(1.0f), GetGLMVec3(scalingV));
-
-            aiQuaternion rotationQ;
-            calcInterpolatedRotation(rotationQ, animationTime, nodeAnim);
-            glm::mat4 rotationM = glm::toMat4(GetGLMQuat(rotationQ));
-
-            aiVector3D translationV;
-            calcInterpolatedPosition(translationV, animationTime, nodeAnim);
-            glm::mat4 translationM = glm::translate(glm::mat4(1.0f), GetGLMVec3(translationV));
-
-            nodeTransformation = translationM * rotationM * scalingM;
-        }
-
-        glm::mat4 globalTransformation = parentTransform * nodeTransformation;
+        std::map<std::string, int> nodeIndices;
+        flattenNode(scene->mRootNode, -1, nodeIndices);
+        globalTransforms.resize(nodes.size());
 
-        if (boneMapping.find(nodeName) != boneMapping.end())
+        clips.resize(numAnimations);
+        for (unsigned int a = 0; a < numAnimations; ++a)
         {
-            unsigned int boneIndex = boneMapping[nodeName];
-            boneMatrices[boneIndex].FinalTransformation = globalInverseTransform * globalTransformation * boneMatrices[boneIndex].BoneOffset;
+            const aiAnimation* animation = scene->mAnimations[a];
+            Clip& clip = clips[a];
+            clip.name = animation->mName.C_Str();
+            clip.duration = (float)animation->mDuration;
+            clip.ticksPerSecond = (float)(animation->mTicksPerSecond != 0.0 ? animation->mTicksPerSecond : 25.0f);
+            clip.nodeChannels.assign(nodes.size(), -1);
+            for (unsigned int c = 0; c < animation->mNumChannels; ++c)
+            {
+                const aiNodeAnim* nodeAnim = animation->mChannels[c];
+                auto node = nodeIndices.find(nodeAnim->mNodeName.C_Str());
+                if (node == nodeIndices.end())
+                    continue;
+                clip.nodeChannels[node->second] = static_cast<int>(clip.channels.size());
+                clip.channels.push_back(bakeChannel(nodeAnim));
+            }
         }
+    }
 
+    void flattenNode(const aiNode* node, int parent, std::map<std::string, int>& nodeIndices)
+    {
+        int index = static_cast<int>(nodes.size());
+        auto bone = boneMapping.find(node->mName.C_Str());
+        nodes.push_back({ parent, bone != boneMapping.end() ? static_cast<int>(bone->second) : -1, GetGLMMat4(node->mTransformation) });
+        nodeIndices.emplace(node->mName.C_Str(), index);
         for (unsigned int i = 0; i < node->mNumChildren; ++i)
-            readNodeHeirarchy(animationTime, node->mChildren[i], globalTransformation);
+            flattenNode(node->mChildren[i], index, nodeIndices);
     }
 
-    const aiNodeAnim* findNodeAnim(const aiAnimation* animation, const std::string nodeName)
+    static Channel bakeChannel(const aiNodeAnim* nodeAnim)
     {
-        for (unsigned int i = 0; i < animation->mNumChannels; ++i)
+        Channel channel;
+        for (unsigned int i = 0; i < nodeAnim->mNumPositionKeys; ++i)
         {
-            const aiNodeAnim* nodeAnim = animation->mChannels[i];
-            if (std::string(nodeAnim->mNodeName.data) == nodeName)
-                return nodeAnim;
+            channel.positionTimes.push_back((float)nodeAnim->mPositionKeys[i].mTime);
+            channel.positions.push_back(GetGLMVec3(nodeAnim->mPositionKeys[i].mValue));
         }
-
-        return nullptr;
+        for (unsigned int i = 0; i < nodeAnim->mNumRotationKeys; ++i)
+        {
+            channel.rotationTimes.push_back((float)nodeAnim->mRotationKeys[i].mTime);
+            channel.rotations.push_back(GetGLMQuat(nodeAnim->mRotationKeys[i].mValue));
+        }
+        for (unsigned int i = 0; i < nodeAnim->mNumScalingKeys; ++i)
+        {
+            channel.scalingTimes.push_back((float)nodeAnim->mScalingKeys[i].mTime);
+            channel.scales.push_back(GetGLMVec3(nodeAnim->mScalingKeys[i].mValue));
+        }
+        // Assimp guarantees at least one key per track, keep sampling branch-free if a file does not
+        if (channel.positions.empty()) { channel.positionTimes.push_back(0.0f); channel.positions.push_back(glm::vec3(0.0f)); }
+        if (channel.rotations.empty()) { channel.rotationTimes.push_back(0.0f); channel.rotations.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f)); }
+        if (channel.scales.empty()) { channel.scalingTimes.push_back(0.0f); channel.scales.push_back(glm::vec3(1.0f)); }
+        return channel;
     }
 
     void setAnimParams()
     {
-        ticksPerSecond = (float)(scene->mAnimations[currentAnimation]->mTicksPerSecond != 0.0
-                               ? scene->mAnimations[currentAnimation]->mTicksPerSecond : 25.0f);
-        animDuration = (float)scene->mAnimations[currentAnimation]->mDuration;
+        if (!hasAnimations)
+            return;
+        const Clip& clip = clips[currentAnimation];
+        cursors.assign(clip.channels.size(), KeyCursor{});
+        ticksPerSecond = clip.ticksPerSecond;
+        animDuration = clip.duration;
     }
 
     // Load material textures from Assimp
-    std::vector<Texture> loadMaterialTextures(const aiScene* scene, aiMaterial* material, aiTextureType textureType, const std::string& typeName)
+    std::vector<Texture> loadMaterialTextures(const aiScene* scene, aiMaterial* material, aiTextureType textureType, TextureSlot slot)
     {
         std::vector<Texture> textures;
         for (unsigned int i = 0; i < material->GetTextureCount(textureType); ++i)
@@ -423,6 +458,7 @@ private:
                 if (std::strcmp(loadedTextures[j].path.data(), textureFilename.C_Str()) == 0)
                 {
                     textures.emplace_back(loadedTextures[j]);
+                    textures.back().slot = slot;
                     skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
                     break;
                 }
@@ -436,7 +472,7 @@ private:
                 else
                     texture2D = Texture2D(std::string(directory + "/" + std::string(textureFilename.C_Str())));
 
-                Texture tex = { texture2D, typeName, std::string(textureFilename.C_Str()) };
+                Texture tex = { texture2D, slot, std::string(textureFilename.C_Str()) };
                 textures.push_back(tex);
                 loadedTextures.push_back(tex);
             }
@@ -1,19 +1,26 @@
 #pragma once
 
+#include "gl_state.hpp"
+#include "gpu_memory.hpp"
+#include "image_decoder.hpp"
+#include "texture_uploads.hpp"
+
 #include "assimp/texture.h"
 #include <glad/gl.h>
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
 
 #include <iostream>
+#include <memory>
 #include <string>
+#include <vector>
 
+// Sampling state, applied through shared sampler objects (see SamplerCache) rather than baked into the texture
 struct TextureParams
 {
     GLuint wrapS = GL_CLAMP_TO_EDGE;
     GLuint wrapT = GL_CLAMP_TO_EDGE;
     GLuint filterMin = GL_NEAREST_MIPMAP_LINEAR;
     GLuint filterMax = GL_NEAREST;
+    bool srgb = true; // Color data: mips are filtered in linear space
 };
 
 class Texture2D
@@ -24,82 +31,95 @@ public:
     GLuint InternalFormat, ImageFormat;
     GLuint WrapS, WrapT;
     GLuint FilterMin, FilterMax;
+    GLenum Target = GL_TEXTURE_2D;
+    GLint Layer = -1; // Layer within a GL_TEXTURE_2D_ARRAY, see TextureArrayPool
+    std::string Name = "texture"; // Asset the GPU memory is accounted to
 
     Texture2D() = default;
 
-    Texture2D(const std::string& path, const TextureParams& params = {})
-        : WrapS(params.wrapS), WrapT(params.wrapT),
+    // Empty texture whose levels are provided later through UploadLevels
+    explicit Texture2D(const TextureParams& params)
+        : Width(0), Height(0), InternalFormat(GL_RGBA), ImageFormat(GL_RGBA),
+          WrapS(params.wrapS), WrapT(params.wrapT),
           FilterMin(params.filterMin), FilterMax(params.filterMax)
     {
         glGenTextures(1, &ID);
-        unsigned char* image = loadImageFromPath(path.c_str());
-        if (image)
-        {
-            generate(image);
-            stbi_image_free(image); // Free after texture generation
-        }
-        else
-        {
-            std::cerr << "ERROR::TEXTURE2D: Failed to load texture: " << path << std::endl;
-        }
     }
 
-    Texture2D(unsigned char* data, unsigned int w, unsigned int h, const TextureParams& params = {})
-        : WrapS(params.wrapS), WrapT(params.wrapT),
-          FilterMin(params.filterMin), FilterMax(params.filterMax)
+    // Decoded through TextureUploads; a 1x1 placeholder is bound until the levels arrive
+    Texture2D(const std::string& path, const TextureParams& params = {})
+        : Texture2D(params)
     {
-        glGenTextures(1, &ID);
-        unsigned char* image = loadImageFromData(data, w, h);
-        if (image)
-        {
-            generate(image);
-            stbi_image_free(image); // Free after texture generation
-        }
-        else
-        {
-            std::cerr << "ERROR::TEXTURE2D: Failed to load texture from data" << std::endl;
-        }
+        Name = path;
+        uploadPlaceholder();
+        bool srgb = params.srgb;
+        TextureUploads::GetInstance().Enqueue([path, srgb] { return ImageDecoder::DecodeFile(path, 0, srgb); },
+            [texture = *this](DecodedImage& image) mutable
+            {
+                if (image.IsValid())
+                    texture.UploadLevels(image.levels, 0, image.channels);
+                else
+                    std::cerr << "ERROR::TEXTURE2D: Failed to load texture: " << texture.Name << std::endl;
+            });
+    }
+
+    // The compressed data is copied, as the caller's (e.g. an Assimp scene) may be gone before the decode runs
+    Texture2D(unsigned char* data, unsigned int w, unsigned int h, const TextureParams& params = {},
+        const std::string& name = "embedded texture")
+        : Texture2D(params)
+    {
+        Name = name;
+        uploadPlaceholder();
+        size_t size = (h == 0) ? w : w * h;
+        auto source = std::make_shared<std::vector<unsigned char>>(data, data + size);
+        bool srgb = params.srgb;
+        TextureUploads::GetInstance().Enqueue([source, srgb] { return ImageDecoder::DecodeMemory(source->data(), source->size(), 0, srgb); },
+            [texture = *this](DecodedImage& image) mutable
+            {
+                if (image.IsValid())
+                    texture.UploadLevels(image.levels, 0, image.channels);
+                else
+                    std::cerr << "ERROR::TEXTURE2D: Failed to load texture from data" << std::endl;
+            });
     }
 
     void Bind() const
     {
-        glBindTexture(GL_TEXTURE_2D, ID);
+        GLState::GetInstance().BindTexture(Target, ID);
     }
 
-private:
-    // Helper function to load the image data
-    unsigned char* loadImageFromPath(const char* path)
+    TextureParams GetParams() const
     {
-        int width, height, channels;
-        unsigned char* image = stbi_load(path, &width, &height, &channels, 0);
-        if (image)
-            setParams(width, height, channels);
-        return image;
+        return { .wrapS = WrapS, .wrapT = WrapT, .filterMin = FilterMin, .filterMax = FilterMax };
     }
 
-    unsigned char* loadImageFromData(unsigned char* data, unsigned int w, unsigned int h)
+    // Respecify the texture from levels[first..], so levels[first] becomes GL level 0
+    void UploadLevels(const std::vector<ImageLevel>& levels, size_t first, int channels)
     {
-        int size, width, height, channels;
-        size = (h == 0) ? w : w * h;
-        unsigned char* image = stbi_load_from_memory(data, size, &width, &height, &channels, 0);
-        if (image)
-            setParams(width, height, channels);
-        return image;
+        if (first >= levels.size())
+            return;
+
+        setParams(levels[first].width, levels[first].height, channels);
+        GLState::GetInstance().BindTexture(GL_TEXTURE_2D, ID);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // Small mips of RGB images are not 4-byte aligned
+        size_t bytes = 0;
+        for (size_t i = first; i < levels.size(); ++i)
+        {
+            glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i - first), InternalFormat,
+                levels[i].width, levels[i].height, 0, ImageFormat, GL_UNSIGNED_BYTE, levels[i].pixels.data());
+            bytes += static_cast<size_t>(levels[i].width) * levels[i].height * GpuMemory::BytesPerPixel(InternalFormat);
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        GpuMemory::GetInstance().TrackTexture(ID, bytes, GpuMemoryCategory::Texture, Name);
+        // Levels beyond the new chain may still hold stale data from a previous upload
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levels.size() - first - 1));
     }
 
-    void generate(unsigned char* data)
+private:
+    void uploadPlaceholder()
     {
-        // Create Texture
-        glBindTexture(GL_TEXTURE_2D, ID);
-        glTexImage2D(GL_TEXTURE_2D, 0, InternalFormat, Width, Height, 0, ImageFormat, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-        // Set Texture wrap and filter modes
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, WrapS);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, WrapT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, FilterMin);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, FilterMax);
-        // Unbind texture
-        glBindTexture(GL_TEXTURE_2D, 0);
+        ImageLevel placeholder{ 1, 1, std::vector<unsigned char>(4, 128) };
+        UploadLevels({ placeholder }, 0, 4);
     }
 
     void setParams(int width, int height, int channels)
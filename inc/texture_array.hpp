@@ -0,0 +1,169 @@
+#pragma once
+
+#include "gl_state.hpp"
+#include "gpu_memory.hpp"
+#include "image_decoder.hpp"
+#include "texture_2D.hpp"
+#include "texture_uploads.hpp"
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Packs textures into shared GL_TEXTURE_2D_ARRAYs grouped by size, so meshes using different images of the
+// same group draw with the same bindings and only differ by a layer index. Sampling params are not part of
+// the group: they are carried by the returned Texture2D and applied through sampler objects.
+class TextureArrayPool
+{
+public:
+    static TextureArrayPool& GetInstance()
+    {
+        static TextureArrayPool instance;
+        return instance;
+    }
+
+    // Returns a texture with Target GL_TEXTURE_2D_ARRAY and its Layer; the same path is only loaded once.
+    // The layer is reserved from the image header and filled once TextureUploads has decoded it.
+    Texture2D Load(const std::string& path, const TextureParams& params = {})
+    {
+        for (const auto& group : groups)
+            if (group.srgb == params.srgb)
+                for (size_t layer = 0; layer < group.paths.size(); ++layer)
+                    if (group.paths[layer] == path)
+                        return makeTexture(group, static_cast<GLint>(layer), params);
+
+        unsigned int width, height;
+        if (!ImageDecoder::ReadDimensions(path, width, height))
+        {
+            std::cerr << "ERROR::TEXTUREARRAY: Failed to load texture: " << path << std::endl;
+            return Texture2D();
+        }
+
+        Group* group = findGroup(width, height, params.srgb);
+        if (!group)
+        {
+            groups.push_back({ 0, width, height, params.srgb, 0, 0, {} });
+            group = &groups.back();
+            allocate(*group);
+        }
+
+        // Grey until decoded; only this layer is written, the ones before it keep their pixels
+        GLint layer = static_cast<GLint>(group->paths.size());
+        group->paths.push_back(path);
+        std::vector<unsigned char> grey(static_cast<size_t>(width) * height * CHANNELS, 128);
+        fillLayer(*group, layer, [&grey](GLsizei) { return grey.data(); });
+
+        // Groups are never removed, so their index stays valid
+        size_t groupIndex = static_cast<size_t>(group - groups.data());
+        bool srgb = params.srgb;
+        TextureUploads::GetInstance().Enqueue([path, srgb] { return ImageDecoder::DecodeFile(path, CHANNELS, srgb); },
+            [this, groupIndex, layer](DecodedImage& image) { finishLayer(groupIndex, layer, image); });
+        return makeTexture(*group, layer, params);
+    }
+
+    size_t GetNumArrays() const { return groups.size(); }
+
+private:
+    // One array of a size, allocated once with room for a fixed number of layers; a full group is followed
+    // by another array of the same size rather than reallocated
+    struct Group
+    {
+        GLuint ID;
+        GLuint width, height;
+        bool srgb; // Mips of color data are filtered differently, so it cannot share an array with linear data
+        GLsizei capacity;
+        GLsizei numLevels;
+        std::vector<std::string> paths; // One per used layer
+    };
+
+    static constexpr int CHANNELS = 4;
+    static constexpr size_t ARRAY_BYTES = 64 * 1024 * 1024; // Layers per array are sized to fit, mips included
+    static constexpr GLsizei MAX_LAYERS = 64;
+
+    std::vector<Group> groups;
+
+    TextureArrayPool() {}
+    TextureArrayPool(const TextureArrayPool&) = delete;
+    TextureArrayPool& operator=(const TextureArrayPool&) = delete;
+
+    Group* findGroup(GLuint width, GLuint height, bool srgb)
+    {
+        for (auto& group : groups)
+            if (group.width == width && group.height == height && group.srgb == srgb
+                && static_cast<GLsizei>(group.paths.size()) < group.capacity)
+                return &group;
+        return nullptr;
+    }
+
+    static GLuint levelSize(GLuint size, GLsizei level) { return std::max(size >> level, 1u); }
+
+    // Specifies every level for the group's full capacity once, without pixels
+    void allocate(Group& group)
+    {
+        size_t layerBytes = 0;
+        group.numLevels = 0;
+        do
+        {
+            layerBytes += static_cast<size_t>(levelSize(group.width, group.numLevels)) * levelSize(group.height, group.numLevels) * CHANNELS;
+            ++group.numLevels;
+        } while (levelSize(group.width, group.numLevels - 1) > 1 || levelSize(group.height, group.numLevels - 1) > 1);
+
+        GLint maxLayers = 256;
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+        group.capacity = static_cast<GLsizei>(std::clamp<size_t>(ARRAY_BYTES / layerBytes, 1,
+            static_cast<size_t>(std::min<GLint>(maxLayers, MAX_LAYERS))));
+
+        glGenTextures(1, &group.ID);
+        GLState::GetInstance().BindTexture(GL_TEXTURE_2D_ARRAY, group.ID);
+        for (GLsizei level = 0; level < group.numLevels; ++level)
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA, levelSize(group.width, level), levelSize(group.height, level),
+                group.capacity, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, group.numLevels - 1);
+        GpuMemory::GetInstance().TrackTexture(group.ID, layerBytes * group.capacity, GpuMemoryCategory::Texture,
+            "texture array " + std::to_string(group.width) + "x" + std::to_string(group.height));
+    }
+
+    // Writes every level of one layer; pixels(level) returns that level's data
+    template<typename Pixels>
+    void fillLayer(const Group& group, GLint layer, Pixels pixels)
+    {
+        GLState::GetInstance().BindTexture(GL_TEXTURE_2D_ARRAY, group.ID);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (GLsizei level = 0; level < group.numLevels; ++level)
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, levelSize(group.width, level), levelSize(group.height, level), 1,
+                GL_RGBA, GL_UNSIGNED_BYTE, pixels(level));
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+
+    // Replaces the grey of a pending layer with its decoded levels; the pixels are not kept
+    void finishLayer(size_t groupIndex, GLint layer, DecodedImage& image)
+    {
+        const Group& group = groups[groupIndex];
+        if (!image.IsValid() || image.levels.size() != static_cast<size_t>(group.numLevels)
+            || image.levels[0].width != group.width || image.levels[0].height != group.height)
+        {
+            std::cerr << "ERROR::TEXTUREARRAY: Failed to load texture: " << group.paths[layer] << std::endl;
+            return;
+        }
+        fillLayer(group, layer, [&image](GLsizei level) { return image.levels[level].pixels.data(); });
+    }
+
+    static Texture2D makeTexture(const Group& group, GLint layer, const TextureParams& params)
+    {
+        Texture2D texture;
+        texture.ID = group.ID;
+        texture.Target = GL_TEXTURE_2D_ARRAY;
+        texture.Layer = layer;
+        texture.Width = group.width;
+        texture.Height = group.height;
+        texture.InternalFormat = texture.ImageFormat = GL_RGBA;
+        texture.WrapS = params.wrapS;
+        texture.WrapT = params.wrapT;
+        texture.FilterMin = params.filterMin;
+        texture.FilterMax = params.filterMax;
+        return texture;
+    }
+};
@@ -0,0 +1,261 @@
+#pragma once
+
+#include "image_decoder.hpp"
+#include "texture_2D.hpp"
+#include "thread_pool.hpp"
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <future>
+#include <iterator>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Streams texture mips under a VRAM budget. Every texture is decoded on worker threads and starts with only
+// its low mips resident; finer mips are requested each frame from on-screen size and decoded again on demand.
+class TextureStreamer
+{
+public:
+    struct Stats
+    {
+        size_t residentBytes = 0;
+        size_t budgetBytes = 0;
+        unsigned int pendingLoads = 0;
+        unsigned int completedLoads = 0;
+        unsigned int evictions = 0;
+    };
+
+    TextureStreamer(ThreadPool& pool, size_t budgetBytes, GLuint baseResidentSize = 64)
+        : pool(pool), budgetBytes(budgetBytes), baseResidentSize(baseResidentSize), frame(0)
+    {
+        stats.budgetBytes = budgetBytes;
+    }
+
+    ~TextureStreamer()
+    {
+        // Workers capture the source data by shared_ptr, but wait so no decode outlives the GL context
+        for (auto& entry : entries)
+            if (entry.pending.valid())
+                entry.pending.wait();
+    }
+
+    Texture2D Load(const std::string& path, const TextureParams& params = {})
+    {
+        return add(std::make_shared<Source>(Source{ path, {}, params.srgb }), params, path);
+    }
+
+    // Compressed image data (e.g. embedded in a .glb), kept in system memory as the streaming source
+    Texture2D Load(const unsigned char* data, unsigned int w, unsigned int h, const TextureParams& params = {},
+        const std::string& name = "embedded texture")
+    {
+        size_t size = (h == 0) ? w : w * h;
+        auto source = std::make_shared<Source>(Source{ "", std::vector<unsigned char>(data, data + size), params.srgb });
+        return add(source, params, name);
+    }
+
+    // Request detail for a texture drawn across screenPixels, with uvDensity UV units across the same extent
+    void RequestDetail(GLuint textureID, float screenPixels, float uvDensity)
+    {
+        auto it = lookup.find(textureID);
+        if (it == lookup.end())
+            return;
+
+        Entry& entry = entries[it->second];
+        if (entry.numMips == 0)
+            return; // Still loading
+        float texels = static_cast<float>(std::max(entry.width, entry.height)) * uvDensity;
+        float texelsPerPixel = texels / std::max(screenPixels, 1.0f);
+        unsigned int mip = texelsPerPixel > 1.0f ? static_cast<unsigned int>(std::floor(std::log2(texelsPerPixel))) : 0;
+        entry.requestedMip = std::min(entry.requestedMip, std::min(mip, entry.numMips - 1));
+        entry.lastUsedFrame = frame;
+    }
+
+    // Upload finished loads, then schedule new ones and evict under budget pressure. Call once per frame on the GL thread.
+    void Update()
+    {
+        stats.pendingLoads = 0;
+        for (auto& entry : entries)
+            if (entry.pending.valid())
+            {
+                if (entry.pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+                    finishLoad(entry);
+                else
+                    stats.pendingLoads++;
+            }
+
+        // Loads still in flight will take their bytes once finished, so they count against the budget too
+        size_t inFlightBytes = 0;
+        for (const auto& entry : entries)
+            if (entry.pending.valid() && entry.pendingMip < entry.residentMip)
+                inFlightBytes += chainBytes(entry, entry.pendingMip) - chainBytes(entry, entry.residentMip);
+
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            Entry& entry = entries[i];
+            if (entry.numMips == 0 || entry.pending.valid() || entry.requestedMip >= entry.residentMip)
+                continue;
+
+            size_t extraBytes = chainBytes(entry, entry.requestedMip) - chainBytes(entry, entry.residentMip);
+            if (stats.residentBytes + inFlightBytes + extraBytes > budgetBytes && !evict(inFlightBytes + extraBytes, i))
+                continue;
+
+            startLoad(entry, entry.requestedMip);
+            inFlightBytes += extraBytes;
+        }
+
+        for (auto& entry : entries)
+            entry.requestedMip = entry.baseMip;
+        frame++;
+    }
+
+    const Stats& GetStats() const { return stats; }
+
+private:
+    struct Source
+    {
+        std::string path;
+        std::vector<unsigned char> data;
+        bool srgb;
+    };
+
+    struct Entry
+    {
+        std::shared_ptr<Source> source;
+        Texture2D texture;
+        GLuint width, height;           // Full resolution
+        unsigned int numMips;
+        unsigned int baseMip;           // Always resident
+        unsigned int residentMip;       // Finest resident mip
+        unsigned int requestedMip;      // Finest mip requested this frame
+        unsigned int pendingMip;
+        uint64_t lastUsedFrame;
+        std::vector<ImageLevel> baseLevels; // Small CPU copy so eviction never touches the disk
+        std::future<DecodedImage> pending;
+    };
+
+    static constexpr int CHANNELS = 4;
+
+    ThreadPool& pool;
+    size_t budgetBytes;
+    GLuint baseResidentSize;
+    uint64_t frame;
+    std::vector<Entry> entries;
+    std::unordered_map<GLuint, size_t> lookup;
+    Stats stats;
+
+    Texture2D add(std::shared_ptr<Source> source, const TextureParams& params, const std::string& name)
+    {
+        // A 1x1 placeholder stays bound until the worker has decoded the base mips
+        Texture2D texture(params);
+        texture.Name = name;
+        ImageLevel placeholder{ 1, 1, std::vector<unsigned char>(CHANNELS, 128) };
+        texture.UploadLevels({ placeholder }, 0, CHANNELS);
+
+        Entry entry;
+        entry.source = std::move(source);
+        entry.texture = texture;
+        entry.width = entry.height = 0;
+        entry.numMips = entry.baseMip = entry.residentMip = entry.requestedMip = 0;
+        entry.lastUsedFrame = frame;
+        startLoad(entry, 0);
+
+        lookup[texture.ID] = entries.size();
+        entries.emplace_back(std::move(entry));
+        return texture;
+    }
+
+    void startLoad(Entry& entry, unsigned int mip)
+    {
+        entry.pendingMip = mip;
+        std::shared_ptr<Source> source = entry.source;
+        entry.pending = pool.Enqueue([source] {
+            return source->path.empty()
+                ? ImageDecoder::DecodeMemory(source->data.data(), source->data.size(), CHANNELS, source->srgb)
+                : ImageDecoder::DecodeFile(source->path, CHANNELS, source->srgb);
+        });
+    }
+
+    void finishLoad(Entry& entry)
+    {
+        DecodedImage image = entry.pending.get();
+        unsigned int mip = entry.pendingMip;
+        if (entry.numMips == 0)
+        {
+            if (image.IsValid())
+                initialize(entry, image.levels);
+            else
+                std::cerr << "ERROR::TEXTURESTREAMER: Failed to load texture: " << entry.source->path << std::endl;
+            return;
+        }
+
+        entry.pendingMip = entry.numMips;
+        // Skip if the source changed on disk or finer detail became resident meanwhile
+        if (image.levels.size() != entry.numMips || mip >= entry.residentMip)
+            return;
+
+        size_t extraBytes = chainBytes(entry, mip) - chainBytes(entry, entry.residentMip);
+        entry.texture.UploadLevels(image.levels, mip, CHANNELS);
+        entry.residentMip = mip;
+        stats.residentBytes += extraBytes;
+        stats.completedLoads++;
+    }
+
+    // First decode: make the low mips resident and keep a CPU copy of them
+    void initialize(Entry& entry, std::vector<ImageLevel>& levels)
+    {
+        entry.width = levels[0].width;
+        entry.height = levels[0].height;
+        entry.numMips = static_cast<unsigned int>(levels.size());
+        entry.baseMip = 0;
+        while (entry.baseMip + 1 < entry.numMips
+            && std::max(levels[entry.baseMip].width, levels[entry.baseMip].height) > baseResidentSize)
+            entry.baseMip++;
+        entry.residentMip = entry.baseMip;
+        entry.requestedMip = entry.baseMip;
+        entry.pendingMip = entry.numMips;
+
+        entry.texture.UploadLevels(levels, entry.baseMip, CHANNELS);
+        entry.baseLevels.assign(std::make_move_iterator(levels.begin() + entry.baseMip), std::make_move_iterator(levels.end()));
+        stats.residentBytes += chainBytes(entry, entry.baseMip);
+    }
+
+    // Drop least-recently-used detail back to the base mips until neededBytes fit. Never evicts the requester.
+    bool evict(size_t neededBytes, size_t requester)
+    {
+        std::vector<size_t> candidates;
+        for (size_t i = 0; i < entries.size(); ++i)
+            if (i != requester && entries[i].residentMip < entries[i].baseMip && entries[i].lastUsedFrame < frame)
+                candidates.push_back(i);
+        std::sort(candidates.begin(), candidates.end(),
+            [this](size_t a, size_t b) { return entries[a].lastUsedFrame < entries[b].lastUsedFrame; });
+
+        for (size_t i : candidates)
+        {
+            if (stats.residentBytes + neededBytes <= budgetBytes)
+                break;
+
+            Entry& entry = entries[i];
+            entry.texture.UploadLevels(entry.baseLevels, 0, CHANNELS);
+            stats.residentBytes -= chainBytes(entry, entry.residentMip) - chainBytes(entry, entry.baseMip);
+            entry.residentMip = entry.baseMip;
+            stats.evictions++;
+        }
+
+        return stats.residentBytes + neededBytes <= budgetBytes;
+    }
+
+    static size_t chainBytes(const Entry& entry, unsigned int mip)
+    {
+        size_t bytes = 0;
+        for (unsigned int i = mip; i < entry.numMips; ++i)
+            bytes += static_cast<size_t>(std::max(entry.width >> i, 1u)) * std::max(entry.height >> i, 1u) * CHANNELS;
+        return bytes;
+    }
+};
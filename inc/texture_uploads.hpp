@@ -0,0 +1,86 @@
+#pragma once
+
+#include "image_decoder.hpp"
+#include "thread_pool.hpp"
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <vector>
+
+// Hands images decoded on a ThreadPool to the GL thread: a load enqueues its decode together with the
+// upload to run on the result, and Update runs the uploads of finished decodes. Without a pool, e.g. in
+// tools that load before one exists, both run at once on the calling thread.
+class TextureUploads
+{
+public:
+    using Upload = std::function<void(DecodedImage&)>;
+
+    static TextureUploads& GetInstance()
+    {
+        static TextureUploads instance;
+        return instance;
+    }
+
+    // Loads still in flight on the previous pool are finished first
+    void SetThreadPool(ThreadPool* newPool)
+    {
+        Finish();
+        pool = newPool;
+    }
+
+    void Enqueue(std::function<DecodedImage()> decode, Upload upload)
+    {
+        if (!pool)
+        {
+            DecodedImage image = decode();
+            upload(image);
+            return;
+        }
+        loads.push_back({ pool->Enqueue(std::move(decode)), std::move(upload) });
+    }
+
+    // Uploads finished decodes, oldest first. Call once per frame on the GL thread.
+    void Update()
+    {
+        for (size_t i = 0; i < loads.size();)
+        {
+            if (loads[i].decode.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+                finish(i);
+            else
+                ++i;
+        }
+    }
+
+    // Waits for every decode and uploads it, e.g. before a benchmark that needs the final textures
+    void Finish()
+    {
+        while (!loads.empty())
+            finish(0);
+    }
+
+    size_t GetNumPending() const { return loads.size(); }
+
+private:
+    struct Load
+    {
+        std::future<DecodedImage> decode;
+        Upload upload;
+    };
+
+    ThreadPool* pool = nullptr;
+    std::vector<Load> loads;
+
+    TextureUploads() {}
+    TextureUploads(const TextureUploads&) = delete;
+    TextureUploads& operator=(const TextureUploads&) = delete;
+
+    // Taken out of the list first, so an upload may enqueue further loads
+    void finish(size_t index)
+    {
+        Load load = std::move(loads[index]);
+        loads.erase(loads.begin() + index);
+        DecodedImage image = load.decode.get();
+        load.upload(image);
+    }
+};
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class ThreadPool
+{
+public:
+    ThreadPool(unsigned int numThreads = DefaultThreadCount())
+        : stopping(false)
+    {
+        workers.reserve(numThreads);
+        for (unsigned int i = 0; i < numThreads; ++i)
+            workers.emplace_back([this] { workerLoop(); });
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        condition.notify_all();
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Queue a task and get a future for its result
+    template<typename F>
+    auto Enqueue(F&& task) -> std::future<std::invoke_result_t<F>>
+    {
+        using Result = std::invoke_result_t<F>;
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> result = packaged->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.emplace([packaged] { (*packaged)(); });
+        }
+        condition.notify_one();
+        return result;
+    }
+
+    // Runs task(i) for every i below count and returns once all have run. Work a frame waits on: the
+    // helpers go ahead of queued tasks, and the calling thread takes indices itself instead of waiting
+    // for a worker to finish e.g. a texture decode.
+    template<typename F>
+    void ParallelFor(size_t count, F&& task)
+    {
+        struct Batch
+        {
+            std::atomic<size_t> next{ 0 };
+            size_t done = 0;
+            std::mutex mutex;
+            std::condition_variable finished;
+        };
+        auto batch = std::make_shared<Batch>();
+        // Helpers that start after every index was taken return without touching task
+        auto run = [batch, count, &task] {
+            size_t ran = 0;
+            for (size_t i = batch->next++; i < count; i = batch->next++, ++ran)
+                task(i);
+            if (ran == 0)
+                return;
+            std::lock_guard<std::mutex> lock(batch->mutex);
+            batch->done += ran;
+            if (batch->done == count)
+                batch->finished.notify_one();
+        };
+
+        size_t helpers = std::min<size_t>(workers.size(), count > 0 ? count - 1 : 0);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t i = 0; i < helpers; ++i)
+                urgentTasks.emplace(run);
+        }
+        for (size_t i = 0; i < helpers; ++i)
+            condition.notify_one();
+        run();
+
+        std::unique_lock<std::mutex> lock(batch->mutex);
+        batch->finished.wait(lock, [&] { return batch->done == count; });
+    }
+
+    unsigned int GetNumThreads() const { return static_cast<unsigned int>(workers.size()); }
+
+    // Leave one core to the main (GL) thread
+    static unsigned int DefaultThreadCount()
+    {
+        unsigned int cores = std::thread::hardware_concurrency();
+        return std::max(1u, cores > 1 ? cores - 1 : 1u);
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::queue<std::function<void()>> urgentTasks; // Taken before tasks
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stopping;
+
+    void workerLoop()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [this] { return stopping || !tasks.empty() || !urgentTasks.empty(); });
+                if (stopping && tasks.empty() && urgentTasks.empty())
+                    return;
+                std::queue<std::function<void()>>& queue = urgentTasks.empty() ? tasks : urgentTasks;
+                task = std::move(queue.front());
+                queue.pop();
+            }
+            task();
+        }
+    }
+};
@@ -0,0 +1,71 @@
+// File: gl_replay.cpp
+// Replays a frame captured with F12 in the app (see GLRecorder) and reports its submission cost.
+// Usage: gl-replay <capture> [iterations]
+#include "gl_replay.hpp"
+
+#include <glad/gl.h>
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: gl-replay <capture> [iterations]" << std::endl;
+        return -1;
+    }
+    const std::string path = argv[1];
+    const unsigned int iterations = argc > 2 ? static_cast<unsigned int>(std::stoul(argv[2])) : 1000;
+
+    // glfw: a hidden window only provides the context, the replay renders offscreen
+    // ------------------------------------------------------------------------------
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+    GLFWwindow* window = glfwCreateWindow(64, 64, "gl-replay", nullptr, nullptr);
+    if (window == nullptr)
+    {
+        std::cerr << "ERROR::GLFW: Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+
+    if (gladLoadGL(glfwGetProcAddress) == 0)
+    {
+        std::cerr << "ERROR::GLAD: Failed to initialize GLAD" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+    int result = 0;
+    {
+        GLReplay replay;
+        if (replay.Load(path) && replay.CreateResources())
+        {
+            const GLCaptureHeader& header = replay.GetHeader();
+            std::cout << "Replaying " << path << ": " << header.numCommands << " commands, " << header.numDraws
+                      << " draws, " << header.width << "x" << header.height << std::endl;
+            std::cout << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
+
+            GLReplay::Result stats = replay.Run(iterations);
+            std::cout << "Iterations: " << stats.Iterations << std::endl
+                      << "Submit (CPU) ms: avg " << stats.SubmitMs << ", min " << stats.MinSubmitMs << ", max " << stats.MaxSubmitMs << std::endl
+                      << "GPU ms: avg " << stats.GpuMs << std::endl;
+        }
+        else
+            result = -1;
+    }
+
+    glfwTerminate();
+    return result;
+}
@@ -1,19 +1,41 @@
 // File: main.cpp
 #include "animated_model.hpp"
+#include "animation_benchmark.hpp"
+#include "animation_texture.hpp"
 #include "cube_model.hpp"
+#include "debug_draw.hpp"
+#include "dynamic_resolution.hpp"
 #include "fps_camera.hpp"
 #include "frustum_box.hpp"
+#include "gbuffer.hpp"
+#include "gl_recorder.hpp"
+#include "gl_state.hpp"
+#include "gpu_crowd.hpp"
+#include "gpu_memory.hpp"
+#include "gpu_timer.hpp"
+#include "ground_chunks.hpp"
+#include "ik_solver.hpp"
+#include "image_decoder.hpp"
+#include "instanced_model.hpp"
+#include "light_clusters.hpp"
 #include "model_loader.hpp"
-#include "plane_model.hpp"
+#include "sampler_cache.hpp"
 #include "shader.hpp"
 #include "texture_2D.hpp"
+#include "texture_streamer.hpp"
+#include "texture_uploads.hpp"
+#include "thread_pool.hpp"
 
 #include <glad/gl.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <glm/ext/matrix_transform.hpp>
+#include <glm/gtc/constants.hpp>
 
+#include <chrono>
+#include <iostream>
 #include <memory>
+#include <random>
 
 void FramebufferSizeCallback(GLFWwindow* window, int width, int height);
 void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
@@ -21,17 +43,57 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
 void CursorPosCallback(GLFWwindow* window, double xposIn, double yposIn);
 
 void ProcessInput(GLFWwindow* window, float deltaTime);
-void Render(const Shader& shader);
+void Render(const Shader& shader, const glm::mat4& cullMatrix);
 
+void UpdateCrowd(float deltaTime);
+void RenderGpuCrowd(const Shader& shader);
+void SolveIK();
+void UpdateLights(float time);
+float GroundHeight(float x, float z);
+void RequestTextureDetail(const BasicModel& model, const glm::vec3& center, float radius);
 void RenderQuad();
 std::vector<glm::vec3> GetFrustumCornersWorldSpace(const glm::mat4& viewProjMatrix);
 glm::mat4 CalcLightSpaceMatrix(const glm::vec3& worldMin, const glm::vec3& worldMax);
 
+// Extra copy of the animated model with its own playback, drawn through the shared meshes
+struct CrowdAgent
+{
+    glm::vec3 Position;
+    PlaybackClock Clock;
+    BonePalette SampledPalette;
+    std::vector<glm::mat4> SampledModelSpace; // Kept for IK, which never writes to the sampled pose
+    BonePalette Palette; // The pose after IK
+    std::vector<glm::mat4> ModelSpace;
+};
+
 FPSCamera Camera;
 std::shared_ptr<CubeModel> Cube;
-std::shared_ptr<PlaneModel> Floor;
-std::unique_ptr<AnimatedModel> AnimModel;
+std::unique_ptr<InstancedModel> Props; // Every cube in the scene, drawn with one instanced call per pass
+struct PropFootprint
+{
+    glm::mat4 ToLocal; // World to the unit cube's space
+    glm::vec2 Center;  // World XZ
+    float Radius;      // Of the circle around the footprint, to skip far cubes cheaply
+    float Top;
+};
+std::vector<PropFootprint> PropFootprints; // Derived from the Props transforms, read by GroundHeight
+std::unique_ptr<GroundChunks> Ground;
+std::unique_ptr<AnimationRuntime> AnimModel;
+std::unique_ptr<ThreadPool> Workers;
+std::unique_ptr<TextureStreamer> Streamer;
+std::unique_ptr<LightClusters> Clusters;
+std::vector<LightClusters::Light> Lights;
+std::vector<glm::vec3> LightAnchors; // Centers of the circles the lights move on
+std::vector<CrowdAgent> Crowd;
+AnimationTexture CrowdAnimations;
+GpuCrowd BackgroundCrowd;
+PlaybackClock BackgroundCrowdClock;
+BonePalette HeroPalette; // The main model's pose after IK
+std::vector<glm::mat4> HeroModelSpace;
+IKSolver::Stats IKStats;
+bool IKApplied = false;
 
+bool CaptureNextFrame = false;
 bool FirstMouse = true;
 float LastX, LastY;
 
@@ -44,15 +106,47 @@ struct Settings
     int WindowPositionY = 0;
     bool FullScreen = false;
     float FOV = 75.0f;
-    float WorldSize = 10.0f;
+    float GroundChunkSize = 16.0f;
+    int GroundLoadRadius = 4; // Ground chunks kept around the camera in each direction
+    float ShadowDistance = 10.0f; // Side of the shadowed box, which follows the camera
     glm::vec3 LightDir = glm::normalize(glm::vec3(0.5f, 1.0f, 1.0f));
     glm::vec3 LightColor = glm::vec3(1.0f, 1.0f, 0.8f);
     glm::vec3 AmbientColor = glm::vec3(1.0f, 1.0f, 1.0f);
     float AmbientIntensity = 0.5f;
     float SpecularShininess = 32.0f;
     float SpecularIntensity = 0.5;
+    int PropCount = 0; // Extra cubes scattered around the scene as instanced props
+    float PropArea = 100.0f; // Side of the square the props are scattered over
+    int LightCount = 0; // Small point and spot lights circling over the light area
+    float LightArea = 40.0f; // Side of the square the lights are scattered over
+    float LightRadius = 3.0f;
+    bool ClusteredLighting = true; // Shades the lights through per-cluster light lists
+    float TextureBudgetMB = 64.0f;
+    FilterQuality TextureFiltering = FilterQuality::High;
+    bool DynamicResolutionScaling = false; // Renders offscreen at a scale that holds the GPU budget, then upscales
+    float MinResolutionScale = 0.5f;
+    float MaxResolutionScale = 1.0f;
+    float GpuBudgetMilliseconds = 14.0f; // GPU time per frame dynamic resolution aims for
+    bool DeferredShading = false; // G-buffer and one full-screen lighting pass instead of forward shading, chosen at startup
+    bool BenchmarkRenderers = false; // Times forward against deferred shading on a scripted orbit at startup
+    bool BenchmarkImageDecode = false;
+    bool BenchmarkAnimation = false; // Runs the model's clips through every animation backend at startup
+    AnimationBackend ModelBackend = AnimationBackend::Ozz;
+    float AnimationSpeed = 1.0f;
+    bool LogAnimationEvents = false; // Prints the main model's clip events as playback crosses them
+    int CrowdSize = 0; // CPU-animated copies of the model in rows behind it
+    int CrowdPhases = 4; // Distinct phase offsets across the crowd
+    float PoseCacheRate = 0.0f; // Pose cache quantization in samples per second, 0 disables it
+    int GpuCrowdSize = 0; // Copies animated entirely on the GPU from baked clips, behind the CPU crowd
+    float GpuCrowdBakeRate = 30.0f; // Frames per second baked into the animation texture
+    bool IK = false; // Foot placement and look-at towards the camera, ozz backend only
+    float IKBudgetMicroseconds = 20.0f; // Per instance and frame, instances over it keep their animated pose
+    float GpuMemoryLogInterval = 10.0f; // Seconds between GPU memory log lines, 0 disables them
+    std::string CapturePath = "frame.glcapture"; // F12 records the next frame for gl-replay
     bool DebugShadow = false;
     bool DebugFrustum = false;
+    bool DebugSkeleton = false;
+    int DebugWeightJoint = -1; // Joint whose skinning weights are shown as a heat-map, -1 for none
     bool Animate = true;
     unsigned int CurrentAnimation = 1;
 } Settings;
@@ -117,46 +211,206 @@ int main()
         return -1;
     }
 
-    Floor = std::make_shared<PlaneModel>("assets/texture_05.png", Settings.WorldSize);
+    SamplerCache::GetInstance().Init();
+    SamplerCache::GetInstance().SetQuality(Settings.TextureFiltering);
+
+    Workers = std::make_unique<ThreadPool>();
+    TextureUploads::GetInstance().SetThreadPool(Workers.get());
+    Streamer = std::make_unique<TextureStreamer>(*Workers, static_cast<size_t>(Settings.TextureBudgetMB * 1024.0f * 1024.0f));
+    if (Settings.BenchmarkImageDecode)
+        ImageDecoder::Benchmark(*Workers, "assets");
+
+    GroundChunks::Config groundConfig;
+    groundConfig.ChunkSize = Settings.GroundChunkSize;
+    groundConfig.LoadRadius = Settings.GroundLoadRadius;
+    Ground = std::make_unique<GroundChunks>(*Workers, "assets/texture_05.png", groundConfig);
     Cube = std::make_shared<CubeModel>("assets/texture_05.png");
+    Props = std::make_unique<InstancedModel>(Cube, "cube instances");
+    Props->Add(glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 0.5f, 2.0f)));
+    Props->Add(glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(-1.0f, 1.0f, -3.0f)), glm::vec3(2.0f)));
+    std::mt19937 propRandom(1);
+    std::uniform_real_distribution<float> propPosition(-Settings.PropArea / 2.0f, Settings.PropArea / 2.0f);
+    std::uniform_real_distribution<float> propSize(0.05f, 0.3f), propYaw(0.0f, glm::two_pi<float>());
+    for (int i = 0; i < Settings.PropCount; ++i)
+    {
+        float size = propSize(propRandom);
+        glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(propPosition(propRandom), size / 2.0f, propPosition(propRandom)));
+        transform = glm::rotate(transform, propYaw(propRandom), glm::vec3(0.0f, 1.0f, 0.0f));
+        Props->Add(glm::scale(transform, glm::vec3(size)));
+    }
+    for (size_t i = 0; i < Props->GetCount(); ++i)
+    {
+        const glm::mat4& transform = Props->Get(i);
+        float scale = glm::length(glm::vec3(transform[0]));
+        PropFootprints.push_back({ glm::inverse(transform), glm::vec2(transform[3].x, transform[3].z),
+            scale * glm::root_two<float>() / 2.0f, (transform * glm::vec4(0.0f, 0.5f, 0.0f, 1.0f)).y });
+    }
+
+    // Every fourth light is a spot pointing down, the rest are points
+    Clusters = std::make_unique<LightClusters>();
+    std::uniform_real_distribution<float> lightPosition(-Settings.LightArea / 2.0f, Settings.LightArea / 2.0f);
+    std::uniform_real_distribution<float> lightHeight(0.5f, 2.5f), lightHue(0.0f, 1.0f);
+    for (int i = 0; i < Settings.LightCount; ++i)
+    {
+        LightClusters::Light light;
+        light.Radius = Settings.LightRadius;
+        float hue = lightHue(propRandom);
+        light.Color = 4.0f * glm::clamp(glm::abs(glm::fract(hue + glm::vec3(0.0f, 2.0f, 1.0f) / 3.0f) * 6.0f - 3.0f) - 1.0f, 0.0f, 1.0f);
+        if (i % 4 == 3)
+        {
+            light.InnerCos = std::cos(glm::radians(20.0f));
+            light.OuterCos = std::cos(glm::radians(30.0f));
+        }
+        Lights.push_back(light);
+        LightAnchors.push_back(glm::vec3(lightPosition(propRandom), lightHeight(propRandom), lightPosition(propRandom)));
+    }
+
+    if (Settings.BenchmarkAnimation)
+        AnimationBenchmark::Run("assets/vanguard.glb");
 
-    AnimModel = std::make_unique<AnimatedModel>();
     ModelLoader& gltf = ModelLoader::GetInstance();
-    gltf.LoadFromFile("assets/vanguard.glb", *AnimModel);
+    gltf.SetTextureStreamer(Streamer.get());
+    AnimModel = gltf.LoadAnimated("assets/vanguard.glb", Settings.ModelBackend);
+    if (!AnimModel)
+    {
+        std::cerr << "ERROR::MODEL: Failed to load \"assets/vanguard.glb\"" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    // Bake before the pose cache is enabled, so the texture holds exact poses
+    if (Settings.GpuCrowdSize > 0 && CrowdAnimations.Bake(*AnimModel, Settings.GpuCrowdBakeRate))
+    {
+        // Rows start behind the CPU crowd's eight columns; clips alternate and starts spread over the clip
+        const int columns = 32;
+        const float firstRow = -3.0f - (Settings.CrowdSize + 7) / 8;
+        std::vector<GpuCrowd::Agent> agents;
+        for (int i = 0; i < Settings.GpuCrowdSize; ++i)
+        {
+            GpuCrowd::Agent agent;
+            agent.position = glm::vec3((i % columns - (columns - 1) * 0.5f) * 0.75f, 0.0f, firstRow - (i / columns) * 0.75f);
+            agent.yaw = 0.0f;
+            agent.clip = static_cast<unsigned int>(i) % CrowdAnimations.GetNumClips();
+            agent.startTime = -CrowdAnimations.GetDuration(agent.clip) * (i % 7) / 7.0f;
+            agent.rate = Settings.AnimationSpeed;
+            agents.push_back(agent);
+        }
+        BackgroundCrowd.Build(agents);
+    }
     AnimModel->SetCurrentAnimation(Settings.CurrentAnimation);
+    AnimModel->GetClock().Rate = Settings.AnimationSpeed;
+    if (Settings.LogAnimationEvents)
+        AnimModel->SetEventHandler([](const AnimationEvent& event)
+            { std::cout << "Animation event \"" << event.Name << "\" at " << event.Time << "s" << std::endl; });
+    if (PoseCache* poseCache = AnimModel->GetPoseCache())
+        poseCache->SetQuantization(Settings.PoseCacheRate);
+    if (IKSolver* ikSolver = AnimModel->GetIKSolver())
+    {
+        ikSolver->GetConfig().BudgetMicroseconds = Settings.IKBudgetMicroseconds;
+        ikSolver->GetConfig().GroundHeight = GroundHeight;
+    }
+    const int crowdColumns = 8, crowdPhases = std::max(Settings.CrowdPhases, 1);
+    for (int i = 0; i < Settings.CrowdSize; ++i)
+    {
+        CrowdAgent agent;
+        agent.Position = glm::vec3(i % crowdColumns - (crowdColumns - 1) * 0.5f, 0.0f, -2.0f - i / crowdColumns);
+        agent.Clock.Rate = Settings.AnimationSpeed;
+        agent.Clock.Phase = static_cast<double>(i % crowdPhases) / crowdPhases;
+        Crowd.push_back(agent);
+    }
 
     Camera.Position = glm::vec3(0.0f, 2.0f, 2.0f);
     Camera.FOV = Settings.FOV;
     Camera.AspectRatio = static_cast<GLfloat>(Settings.WindowWidth) / static_cast<GLfloat>(Settings.WindowHeight);
 
-    glm::vec3 worldMin(-Settings.WorldSize / 2.0f, 0.0f, -Settings.WorldSize / 2.0f);
-    glm::vec3 worldMax(Settings.WorldSize / 2.0f, Settings.WorldSize / 2.0f, Settings.WorldSize / 2.0f);
-    glm::mat4 lightViewSpaceMatrix = CalcLightSpaceMatrix(worldMin, worldMax);
-    std::vector<glm::vec3> worldFrustumCorners = {
-        { worldMin.x, worldMin.y, worldMin.z }, { worldMax.x, worldMin.y, worldMin.z },
-        { worldMin.x, worldMax.y, worldMin.z }, { worldMax.x, worldMax.y, worldMin.z },
-        { worldMin.x, worldMin.y, worldMax.z }, { worldMax.x, worldMin.y, worldMax.z },
-        { worldMin.x, worldMax.y, worldMax.z }, { worldMax.x, worldMax.y, worldMax.z }
-    };
-    FrustumBox lightSpaceFrustum(GetFrustumCornersWorldSpace(lightViewSpaceMatrix), glm::vec3(1.0f, 1.0f, 0.0f));
-    FrustumBox worldFrustum(worldFrustumCorners, glm::vec3(1.0f, 0.0f, 0.0f));
+    // Set by fitShadow below, once the shaders exist
+    glm::mat4 lightViewSpaceMatrix(1.0f);
+    glm::vec2 shadowCenter(FLT_MAX);
+    FrustumBox lightSpaceFrustum({}, glm::vec3(1.0f, 1.0f, 0.0f));
+    FrustumBox worldFrustum({}, glm::vec3(1.0f, 0.0f, 0.0f));
 
+    // The GPU crowd shares default.fs, so its shader gets the same lighting setup
+    auto setupLitShader = [&](const Shader& shader)
+    {
+        shader.Use();
+        shader.SetMat4("projectionMatrix", Camera.GetProjectionMatrix());
+        shader.SetMat4("lightSpaceMatrix", lightViewSpaceMatrix);
+        shader.SetVec3("lightDir", Settings.LightDir);
+        shader.SetVec3("lightColor", Settings.LightColor);
+        shader.SetVec3("ambientColor", Settings.AmbientColor);
+        shader.SetFloat("ambientIntensity", Settings.AmbientIntensity);
+        shader.SetFloat("specularShininess", Settings.SpecularShininess);
+        shader.SetFloat("specularIntensity", Settings.SpecularIntensity);
+        shader.SetInt("depthMap", 3);
+        Material::SetSamplerUnits(shader);
+        LightClusters::SetSamplerUnits(shader);
+    };
     Shader defaultShader("shaders/default.vs", "shaders/default.fs");
-    defaultShader.Use();
-    defaultShader.SetMat4("projectionMatrix", Camera.GetProjectionMatrix());
-    defaultShader.SetMat4("lightSpaceMatrix", lightViewSpaceMatrix);
-    defaultShader.SetVec3("lightDir", Settings.LightDir);
-    defaultShader.SetVec3("lightColor", Settings.LightColor);
-    defaultShader.SetVec3("ambientColor", Settings.AmbientColor);
-    defaultShader.SetFloat("ambientIntensity", Settings.AmbientIntensity);
-    defaultShader.SetFloat("specularShininess", Settings.SpecularShininess);
-    defaultShader.SetFloat("specularIntensity", Settings.SpecularIntensity);
-    defaultShader.SetInt("depthMap", 3);
+    setupLitShader(defaultShader);
+
+    Shader crowdShader("shaders/crowd.vs", "shaders/default.fs");
+    setupLitShader(crowdShader);
+    crowdShader.SetBool("shadowPass", false);
+    crowdShader.SetInt("debugWeightJoint", -1);
 
     Shader shadowShader("shaders/default.vs", "shaders/shadow.fs");
     shadowShader.Use();
     shadowShader.SetMat4("lightSpaceMatrix", lightViewSpaceMatrix);
 
+    Shader crowdShadowShader("shaders/crowd.vs", "shaders/shadow.fs");
+    crowdShadowShader.Use();
+    crowdShadowShader.SetMat4("lightSpaceMatrix", lightViewSpaceMatrix);
+    crowdShadowShader.SetBool("shadowPass", true);
+
+    // Deferred path: geometry into the G-buffer, lit by one full-screen pass
+    Shader gBufferShader("shaders/default.vs", "shaders/gbuffer.fs");
+    Shader crowdGBufferShader("shaders/crowd.vs", "shaders/gbuffer.fs");
+    for (const Shader* shader : { &gBufferShader, &crowdGBufferShader })
+    {
+        shader->Use();
+        shader->SetMat4("projectionMatrix", Camera.GetProjectionMatrix());
+        shader->SetBool("shadowPass", false);
+        shader->SetInt("debugWeightJoint", -1);
+        shader->SetFloat("specularShininess", Settings.SpecularShininess);
+        Material::SetSamplerUnits(*shader);
+    }
+    Shader deferredShader("shaders/render_to_quad.vs", "shaders/deferred.fs");
+    setupLitShader(deferredShader);
+    std::unique_ptr<GBuffer> gBuffer;
+    if (Settings.DeferredShading || Settings.BenchmarkRenderers)
+    {
+        gBuffer = std::make_unique<GBuffer>();
+        if (!gBuffer->Create(Settings.WindowWidth, Settings.WindowHeight))
+            Settings.DeferredShading = Settings.BenchmarkRenderers = false;
+    }
+
+    // The shadowed box follows the camera in steps of a quarter of its size, so the shadow map does not
+    // shimmer while walking and the shaders are only updated when it moves
+    auto fitShadow = [&](const glm::vec3& center)
+    {
+        float step = Settings.ShadowDistance / 4.0f;
+        glm::vec2 snapped = glm::round(glm::vec2(center.x, center.z) / step) * step;
+        if (snapped == shadowCenter)
+            return;
+        shadowCenter = snapped;
+        float halfSize = Settings.ShadowDistance / 2.0f;
+        glm::vec3 worldMin(snapped.x - halfSize, 0.0f, snapped.y - halfSize);
+        glm::vec3 worldMax(snapped.x + halfSize, halfSize, snapped.y + halfSize);
+        lightViewSpaceMatrix = CalcLightSpaceMatrix(worldMin, worldMax);
+        for (const Shader* shader : { &defaultShader, &crowdShader, &shadowShader, &crowdShadowShader, &deferredShader })
+        {
+            shader->Use();
+            shader->SetMat4("lightSpaceMatrix", lightViewSpaceMatrix);
+        }
+        lightSpaceFrustum.SetCorners(GetFrustumCornersWorldSpace(lightViewSpaceMatrix));
+        worldFrustum.SetCorners({
+            { worldMin.x, worldMin.y, worldMin.z }, { worldMax.x, worldMin.y, worldMin.z },
+            { worldMin.x, worldMax.y, worldMin.z }, { worldMax.x, worldMax.y, worldMin.z },
+            { worldMin.x, worldMin.y, worldMax.z }, { worldMax.x, worldMin.y, worldMax.z },
+            { worldMin.x, worldMax.y, worldMax.z }, { worldMax.x, worldMax.y, worldMax.z }
+        });
+    };
+    fitShadow(Camera.Position);
+
     Shader debugShader("shaders/render_to_quad.vs", "shaders/debug_shadows.fs");
     debugShader.Use();
     debugShader.SetInt("depthMap", 0);
@@ -173,8 +427,11 @@ int main()
     // create depth texture
     unsigned int depthMap;
     glGenTextures(1, &depthMap);
-    glBindTexture(GL_TEXTURE_2D, depthMap);
+    GLState& glState = GLState::GetInstance();
+    glState.BindTexture(GL_TEXTURE_2D, depthMap);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    GpuMemory::GetInstance().TrackTexture(depthMap, SHADOW_WIDTH * SHADOW_HEIGHT * GpuMemory::BytesPerPixel(GL_DEPTH_COMPONENT),
+        GpuMemoryCategory::RenderTarget, "shadow map");
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
@@ -182,21 +439,169 @@ int main()
     float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
     glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
     // attach depth texture as FBO's depth buffer
-    glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
+    glState.BindFramebuffer(depthMapFBO);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthMap, 0);
     glDrawBuffer(GL_NONE);
     glReadBuffer(GL_NONE);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glState.BindFramebuffer(0);
 
     // setup OpenGL
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_CULL_FACE);
+    glState.CullFace(GL_BACK);
+
+    std::unique_ptr<DynamicResolution> resolution;
+    if (Settings.DynamicResolutionScaling)
+    {
+        resolution = std::make_unique<DynamicResolution>();
+        if (!resolution->Create(Settings.WindowWidth, Settings.WindowHeight,
+            { Settings.MinResolutionScale, Settings.MaxResolutionScale, Settings.GpuBudgetMilliseconds }))
+            resolution.reset();
+    }
+
+    // Shadow map, then the lit scene into target at size, shaded forward or deferred
+    auto renderScene = [&](bool deferred, GLuint target, glm::ivec2 size)
+    {
+        glState.ClearColor(0.2f, 0.3f, 0.4f, 1.0f);
+        glState.Clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // 1. render depth of scene to texture (from light's perspective)
+        // --------------------------------------------------------------
+        glState.Viewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
+        glState.BindFramebuffer(depthMapFBO);
+            glState.Clear(GL_DEPTH_BUFFER_BIT);
+            glState.CullFace(GL_FRONT);
+            shadowShader.Use();
+            shadowShader.SetBool("shadowPass", true);
+            Render(shadowShader, lightViewSpaceMatrix);
+            RenderGpuCrowd(crowdShadowShader);
+            glState.CullFace(GL_BACK);
+        glState.BindFramebuffer(target);
+
+        // reset viewport
+        glState.Viewport(0, 0, size.x, size.y);
+        glState.Clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // 2. render scene as normal using the generated depth/shadow map
+        // --------------------------------------------------------------
+        if (Settings.DebugShadow)
+        {
+            debugShader.Use();
+            debugShader.SetFloat("nearPlane", Camera.NearPlane);
+            debugShader.SetFloat("farPlane", Camera.FarPlane);
+            glState.BindTexture(0, GL_TEXTURE_2D, depthMap);
+            glState.BindSampler(0, 0);
+            RenderQuad();
+            return;
+        }
+
+        glm::mat4 viewProjection = Camera.GetProjectionMatrix() * Camera.GetViewMatrix();
+        glm::vec2 screenSize(size);
+        bool clustered = Settings.ClusteredLighting && !Lights.empty();
+        if (!deferred)
+        {
+            defaultShader.Use();
+            defaultShader.SetMat4("viewMatrix", Camera.GetViewMatrix());
+            defaultShader.SetVec3("cameraPos", Camera.Position);
+            defaultShader.SetBool("shadowPass", false);
+            defaultShader.SetInt("debugWeightJoint", Settings.DebugWeightJoint);
+            glState.BindTexture(3, GL_TEXTURE_2D, depthMap);
+            glState.BindSampler(3, 0);
+            for (const Shader* shader : { &defaultShader, &crowdShader })
+            {
+                shader->Use();
+                shader->SetBool("clusteredLights", clustered);
+                if (clustered)
+                    Clusters->Bind(*shader, screenSize);
+            }
+            Render(defaultShader, viewProjection);
+            RenderGpuCrowd(crowdShader);
+            return;
+        }
+
+        // Geometry into the G-buffer, then one full-screen pass lights each covered pixel once
+        glState.BindFramebuffer(gBuffer->GetFramebuffer());
+        glState.Clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        Render(gBufferShader, viewProjection);
+        RenderGpuCrowd(crowdGBufferShader);
+        glState.BindFramebuffer(target);
+
+        deferredShader.Use();
+        deferredShader.SetMat4("inverseViewProjection", glm::inverse(viewProjection));
+        deferredShader.SetMat4("viewMatrix", Camera.GetViewMatrix());
+        deferredShader.SetVec3("cameraPos", Camera.Position);
+        deferredShader.SetBool("clusteredLights", clustered);
+        if (clustered)
+            Clusters->Bind(deferredShader, screenSize);
+        gBuffer->Bind(deferredShader);
+        glState.BindTexture(3, GL_TEXTURE_2D, depthMap);
+        glState.BindSampler(3, 0);
+        glState.SetEnabled(GL_DEPTH_TEST, false);
+        RenderQuad();
+        glState.SetEnabled(GL_DEPTH_TEST, true);
+        gBuffer->BlitDepth(target, size.x, size.y);
+    };
+
+    // Forward against deferred on the same scripted orbit, GPU time from timer queries
+    if (Settings.BenchmarkRenderers)
+    {
+        const FPSCamera savedCamera = Camera;
+        const int frames = 300, warmUpFrames = 60;
+        auto placeCamera = [&](int frame)
+        {
+            float angle = glm::two_pi<float>() * static_cast<float>(frame) / frames;
+            Camera.Position = glm::vec3(std::cos(angle) * 6.0f, 2.0f, std::sin(angle) * 6.0f);
+            Camera.LookAt(glm::vec3(0.0f, 1.0f, 0.0f));
+            Ground->Update(Camera.Position);
+            fitShadow(Camera.Position);
+            UpdateLights(static_cast<float>(frame) / 60.0f);
+        };
+        // Lets textures finish and ground chunks stream in before anything is timed
+        TextureUploads::GetInstance().Finish();
+        for (int frame = 0; frame < warmUpFrames; ++frame)
+        {
+            placeCamera(0);
+            renderScene(false, 0, glm::ivec2(Settings.WindowWidth, Settings.WindowHeight));
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+
+        std::cout << "Renderer benchmark: " << frames << " frames orbiting the scene at "
+            << Settings.WindowWidth << "x" << Settings.WindowHeight << std::endl;
+        for (bool deferred : { false, true })
+        {
+            GpuTimer timer;
+            std::vector<float> timings;
+            timings.reserve(frames);
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int frame = 0; frame < frames; ++frame)
+            {
+                placeCamera(frame);
+                timer.Begin();
+                renderScene(deferred, 0, glm::ivec2(Settings.WindowWidth, Settings.WindowHeight));
+                timer.End();
+                glfwSwapBuffers(window);
+                glfwPollEvents();
+                timer.Collect(timings);
+            }
+            timer.Collect(timings, true);
+            double gpuMilliseconds = 0.0;
+            for (float milliseconds : timings)
+                gpuMilliseconds += milliseconds;
+            double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+            std::cout << "  " << (deferred ? "Deferred" : "Forward") << ": " << gpuMilliseconds / frames << " ms GPU, "
+                << seconds * 1000.0 / frames << " ms per frame" << std::endl;
+        }
+        Camera = savedCamera;
+        fitShadow(Camera.Position);
+    }
 
     // game loop
     // -----------
     float currentTime = 0.0f;
     float lastTime    = 0.0f;
     float lastFPSTime = 0.0f;
+    float lastMemoryLogTime = 0.0f;
     float deltaTime   = 0.0f;
     int frames = 0;
     int fps    = 0;
@@ -216,6 +621,11 @@ int main()
             frames = 0;
             lastFPSTime = currentTime;
         }
+        if (Settings.GpuMemoryLogInterval > 0.0f && (currentTime - lastMemoryLogTime) >= Settings.GpuMemoryLogInterval)
+        {
+            GpuMemory::GetInstance().Log();
+            lastMemoryLogTime = currentTime;
+        }
 
         // input
         // -----
@@ -224,61 +634,83 @@ int main()
         // update
         // ------
         if (Settings.Animate)
+        {
+            UpdateCrowd(deltaTime);
+            BackgroundCrowdClock.Advance(deltaTime);
             AnimModel->UpdateAnimation(deltaTime);
+        }
+        SolveIK();
+        RequestTextureDetail(*AnimModel, glm::vec3(0.0f, 1.0f, 0.0f), 1.0f);
+        Streamer->Update();
+        TextureUploads::GetInstance().Update();
+        Ground->Update(Camera.Position);
+        fitShadow(Camera.Position);
+        UpdateLights(static_cast<float>(currentTime));
 
         // render
         // ------
-        glClearColor(0.2f, 0.3f, 0.4f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // 1. render depth of scene to texture (from light's perspective)
-        // --------------------------------------------------------------
-        glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
-        glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-            glClear(GL_DEPTH_BUFFER_BIT);
-            glCullFace(GL_FRONT);
-            shadowShader.Use();
-            shadowShader.SetBool("shadowPass", true);
-            Render(shadowShader);
-            glCullFace(GL_BACK);
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-        // reset viewport
-        glViewport(0, 0, Settings.WindowWidth, Settings.WindowHeight);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // 2. render scene as normal using the generated depth/shadow map
-        // --------------------------------------------------------------
-        if (Settings.DebugShadow)
+        bool capturing = CaptureNextFrame;
+        if (capturing)
         {
-            debugShader.Use();
-            debugShader.SetFloat("nearPlane", Camera.NearPlane);
-            debugShader.SetFloat("farPlane", Camera.FarPlane);
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, depthMap);
-            RenderQuad();
+            // Forget cached state, so every bind of the frame is issued and recorded
+            glState.Invalidate();
+            GLRecorder::GetInstance().BeginCapture(Settings.WindowWidth, Settings.WindowHeight);
+            CaptureNextFrame = false;
         }
-        else
+        GLuint target = 0;
+        glm::ivec2 renderSize(Settings.WindowWidth, Settings.WindowHeight);
+        if (resolution)
         {
-            defaultShader.Use();
-            defaultShader.SetMat4("viewMatrix", Camera.GetViewMatrix());
-            defaultShader.SetVec3("cameraPos", Camera.Position);
-            defaultShader.SetBool("shadowPass", false);
-            glActiveTexture(GL_TEXTURE3);
-            glBindTexture(GL_TEXTURE_2D, depthMap);
-            Render(defaultShader);
+            resolution->Begin();
+            target = resolution->GetFramebuffer();
+            renderSize = resolution->GetRenderSize();
         }
+        renderScene(Settings.DeferredShading, target, renderSize);
 
+        // 3. debug lines submitted during the frame, drawn in one call
+        // ------------------------------------------------------------
         if (Settings.DebugFrustum)
         {
-            lineShader.Use();
-            lineShader.SetMat4("viewMatrix", Camera.GetViewMatrix());
-            lightSpaceFrustum.Draw(lineShader);
-            worldFrustum.Draw(lineShader);
+            lightSpaceFrustum.Draw();
+            worldFrustum.Draw();
         }
+        if (Settings.DebugSkeleton)
+            AnimModel->DrawSkeleton(glm::mat4(1.0f), Settings.DebugWeightJoint);
+        lineShader.Use();
+        lineShader.SetMat4("viewMatrix", Camera.GetViewMatrix());
+        DebugDraw::GetInstance().Flush(lineShader);
+        if (resolution)
+            resolution->End();
+
+        if (capturing)
+            GLRecorder::GetInstance().EndCapture(Settings.CapturePath);
 
         // display FPS in window title
-        glfwSetWindowTitle(window, (Settings.WindowTitle + " - FPS: " + std::to_string(fps)).c_str());
+        GLState::Stats glStats = glState.EndFrame();
+        std::string title = Settings.WindowTitle + " - FPS: " + std::to_string(fps)
+            + " - Texture binds: " + std::to_string(glStats.TextureBinds)
+            + " - GL state calls: " + std::to_string(glStats.Issued) + " issued / " + std::to_string(glStats.Skipped) + " skipped"
+            + " - Ground chunks: " + std::to_string(Ground->GetStats().Drawn) + "/" + std::to_string(Ground->GetStats().Resident);
+        PoseCache* poseCache = AnimModel->GetPoseCache();
+        if (poseCache && poseCache->IsEnabled())
+        {
+            PoseCache::Stats poseStats = poseCache->EndInterval();
+            if (poseStats.Lookups > 0)
+                title += " - Pose cache hits: " + std::to_string(poseStats.Hits * 100 / poseStats.Lookups) + "%";
+        }
+        if (IKApplied && IKStats.Instances > 0)
+            title += " - IK: " + std::to_string(static_cast<int>(IKStats.Microseconds / IKStats.Instances)) + "/"
+                + std::to_string(static_cast<int>(Settings.IKBudgetMicroseconds)) + " us per instance, "
+                + std::to_string(IKStats.Solved) + " chains, " + std::to_string(IKStats.Deferred) + " deferred";
+        if (resolution)
+            title += " - Resolution: " + std::to_string(static_cast<int>(resolution->GetScale() * 100.0f + 0.5f)) + "% at "
+                + std::to_string(static_cast<int>(resolution->GetGpuMilliseconds() * 1000.0f)) + " us GPU";
+        if (Settings.ClusteredLighting && !Lights.empty())
+            title += " - Lights: " + std::to_string(Clusters->GetStats().Lights) + ", up to " + std::to_string(Clusters->GetStats().MaxPerCluster)
+                + " per cluster in " + std::to_string(static_cast<int>(Clusters->GetStats().Microseconds)) + " us";
+        if (Settings.DebugWeightJoint >= 0)
+            title += " - Weights: " + AnimModel->GetJointName(Settings.DebugWeightJoint);
+        glfwSetWindowTitle(window, title.c_str());
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
@@ -288,9 +720,18 @@ int main()
 
     // optional: de-allocate all resources once they've outlived their purpose:
     // ------------------------------------------------------------------------
+    Crowd.clear();
     AnimModel.reset();
-    Floor.reset();
+    Ground.reset();
+    Clusters.reset();
+    gBuffer.reset();
+    resolution.reset();
+    Props.reset();
     Cube.reset();
+    gltf.SetTextureStreamer(nullptr);
+    Streamer.reset();
+    TextureUploads::GetInstance().SetThreadPool(nullptr);
+    Workers.reset();
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
@@ -304,7 +745,7 @@ void FramebufferSizeCallback(GLFWwindow* /* window */, int width, int height)
 {
     // make sure the viewport matches the new window dimensions; note that width and
     // height will be significantly larger than specified on retina displays.
-    glViewport(0, 0, width, height);
+    GLState::GetInstance().Viewport(0, 0, width, height);
 }
 
 // glfw: whenever a mouse button is clicked, this callback is called
@@ -321,7 +762,7 @@ void KeyCallback(GLFWwindow* window, int key, int /* scancode */, int action, in
     else if (key == GLFW_KEY_SPACE && action == GLFW_PRESS)
     {
         Settings.CurrentAnimation = (Settings.CurrentAnimation + 1) % AnimModel->GetNumAnimations();
-        AnimModel->SetCurrentAnimation(Settings.CurrentAnimation);
+        AnimModel->SetCurrentAnimationSynced(Settings.CurrentAnimation);
     }
     else if (key == GLFW_KEY_P && action == GLFW_PRESS)
         Settings.Animate = !Settings.Animate;
@@ -329,6 +770,25 @@ void KeyCallback(GLFWwindow* window, int key, int /* scancode */, int action, in
         Settings.DebugShadow = !Settings.DebugShadow;
     else if (key == GLFW_KEY_F && action == GLFW_PRESS)
         Settings.DebugFrustum = !Settings.DebugFrustum;
+    else if (key == GLFW_KEY_L && action == GLFW_PRESS)
+        Settings.ClusteredLighting = !Settings.ClusteredLighting;
+    else if (key == GLFW_KEY_I && action == GLFW_PRESS)
+        Settings.IK = !Settings.IK;
+    else if (key == GLFW_KEY_K && action == GLFW_PRESS)
+        Settings.DebugSkeleton = !Settings.DebugSkeleton;
+    else if (key == GLFW_KEY_J && action == GLFW_PRESS)
+    {
+        // Cycles through the joints, then back to no heat-map
+        int numJoints = static_cast<int>(AnimModel->GetNumJoints());
+        Settings.DebugWeightJoint = Settings.DebugWeightJoint + 1 < numJoints ? Settings.DebugWeightJoint + 1 : -1;
+    }
+    else if (key == GLFW_KEY_T && action == GLFW_PRESS)
+    {
+        Settings.TextureFiltering = static_cast<FilterQuality>((static_cast<int>(Settings.TextureFiltering) + 1) % 3);
+        SamplerCache::GetInstance().SetQuality(Settings.TextureFiltering);
+    }
+    else if (key == GLFW_KEY_F12 && action == GLFW_PRESS)
+        CaptureNextFrame = true;
 }
 
 // glfw: whenever the mouse moves, this callback is called
@@ -366,7 +826,8 @@ void ProcessInput(GLFWwindow* window, float deltaTime)
         Camera.Move(MOVE_RIGHT, deltaTime);
 }
 
-void Render(const Shader& shader)
+// cullMatrix is the view-projection of the pass, ground chunks outside it are skipped
+void Render(const Shader& shader, const glm::mat4& cullMatrix)
 {
     glm::mat4 translationMatrix, rotationMatrix, scaleMatrix, modelMatrix;
 
@@ -374,25 +835,9 @@ void Render(const Shader& shader)
     shader.SetMat4("viewMatrix", Camera.GetViewMatrix());
     shader.SetVec3("cameraPos", Camera.Position);
 
-    shader.SetMat4("modelMatrix", glm::mat4(1.0f));
-    shader.SetMat3("normalMatrix", glm::mat3(1.0f));
-    Floor->Draw(shader);
+    Ground->Draw(shader, cullMatrix);
 
-    translationMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 0.5f, 2.0f));
-    rotationMatrix = glm::mat4(1.0f);
-    scaleMatrix = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f));
-    modelMatrix = translationMatrix * rotationMatrix * scaleMatrix;
-    shader.SetMat4("modelMatrix", modelMatrix);
-    shader.SetMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(modelMatrix))));
-    Cube->Draw(shader);
-
-    translationMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(-1.0f, 1.0f, -3.0f));
-    rotationMatrix = glm::mat4(1.0f);
-    scaleMatrix = glm::scale(glm::mat4(1.0f), glm::vec3(2.0f));
-    modelMatrix = translationMatrix * rotationMatrix * scaleMatrix;
-    shader.SetMat4("modelMatrix", modelMatrix);
-    shader.SetMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(modelMatrix))));
-    Cube->Draw(shader);
+    Props->Draw(shader);
 
     translationMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 0.0f));
     rotationMatrix = glm::mat4(1.0f);
@@ -400,8 +845,111 @@ void Render(const Shader& shader)
     modelMatrix = translationMatrix * rotationMatrix * scaleMatrix;
     shader.SetMat4("modelMatrix", modelMatrix);
     shader.SetMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(modelMatrix))));
-    AnimModel->SetBoneTransformations(shader);
+    if (IKApplied)
+        HeroPalette.Upload(shader, AnimModel->HasAnimations());
+    else
+        AnimModel->SetBoneTransformations(shader);
     AnimModel->Draw(shader);
+
+    for (const CrowdAgent& agent : Crowd)
+    {
+        shader.SetMat4("modelMatrix", glm::translate(glm::mat4(1.0f), agent.Position));
+        shader.SetMat3("normalMatrix", glm::mat3(1.0f));
+        (IKApplied ? agent.Palette : agent.SampledPalette).Upload(shader, AnimModel->HasAnimations());
+        AnimModel->Draw(shader);
+    }
+}
+
+// Samples every crowd agent through the shared model; with the pose cache enabled, agents in the same
+// phase reuse one pose
+void UpdateCrowd(float deltaTime)
+{
+    const double duration = AnimModel->GetDuration();
+    for (CrowdAgent& agent : Crowd)
+    {
+        agent.Clock.Advance(deltaTime);
+        AnimModel->Sample(static_cast<float>(agent.Clock.GetClipTime(duration)));
+        agent.SampledPalette = AnimModel->GetPalette();
+        if (Settings.IK && AnimModel->GetModelSpace())
+            agent.SampledModelSpace = *AnimModel->GetModelSpace();
+    }
+}
+
+// Corrects the main model and the CPU crowd in one batch on the workers. Every pose is solved from a
+// fresh copy of what was sampled, so paused agents, which are not re-sampled, do not drift.
+void SolveIK()
+{
+    IKSolver* ikSolver = AnimModel->GetIKSolver();
+    IKApplied = Settings.IK && ikSolver && AnimModel->GetModelSpace();
+    if (!IKApplied)
+        return;
+
+    HeroPalette = AnimModel->GetPalette();
+    HeroModelSpace = *AnimModel->GetModelSpace();
+    ikSolver->Add({ glm::mat4(1.0f), Camera.Position, &HeroModelSpace, &HeroPalette });
+    for (CrowdAgent& agent : Crowd)
+    {
+        agent.Palette = agent.SampledPalette;
+        agent.ModelSpace = agent.SampledModelSpace;
+        if (agent.ModelSpace.size() == agent.Palette.GetSize())
+            ikSolver->Add({ glm::translate(glm::mat4(1.0f), agent.Position), Camera.Position, &agent.ModelSpace, &agent.Palette });
+    }
+    IKStats = ikSolver->Solve(Workers.get());
+}
+
+// Moves the lights on their circles, then assigns them to the clusters of the camera's view
+void UpdateLights(float time)
+{
+    if (Lights.empty() || !Settings.ClusteredLighting)
+        return;
+    for (size_t i = 0; i < Lights.size(); ++i)
+    {
+        float angle = time * 0.5f + static_cast<float>(i);
+        Lights[i].Position = LightAnchors[i] + glm::vec3(std::cos(angle), 0.0f, std::sin(angle)) * 1.5f;
+    }
+    Clusters->Build(Lights, Camera.GetViewMatrix(), Camera.GetProjectionMatrix(), Camera.NearPlane, Camera.FarPlane, Workers.get());
+}
+
+// The floor and the tops of the cubes Render draws; props only turn about Y, so a point is over a cube
+// when it is inside the unit square in the cube's space
+float GroundHeight(float x, float z)
+{
+    float height = 0.0f;
+    for (const PropFootprint& prop : PropFootprints)
+    {
+        if (prop.Top <= height || glm::length(glm::vec2(x, z) - prop.Center) > prop.Radius)
+            continue;
+        glm::vec4 local = prop.ToLocal * glm::vec4(x, 0.0f, z, 1.0f);
+        if (std::abs(local.x) <= 0.5f && std::abs(local.z) <= 0.5f)
+            height = prop.Top;
+    }
+    return height;
+}
+
+// One instanced draw per mesh for the whole GPU crowd; the shader must be a crowd.vs program
+void RenderGpuCrowd(const Shader& shader)
+{
+    if (BackgroundCrowd.GetNumAgents() == 0)
+        return;
+    shader.Use();
+    shader.SetMat4("viewMatrix", Camera.GetViewMatrix());
+    shader.SetVec3("cameraPos", Camera.Position);
+    BackgroundCrowd.Draw(shader, *AnimModel, CrowdAnimations, BackgroundCrowdClock.GetElapsed());
+}
+
+// Estimate the on-screen size of a bounding sphere and request texture detail to match
+void RequestTextureDetail(const BasicModel& model, const glm::vec3& center, float radius)
+{
+    float distance = std::max(glm::length(center - Camera.Position) - radius, Camera.NearPlane);
+    float screenPixels = radius / (distance * glm::tan(glm::radians(Camera.FOV) * 0.5f)) * Settings.WindowHeight;
+    for (const auto& mesh : model.GetMeshes())
+    {
+        // screenPixels spans the diameter; a mesh without UVs falls back to one texture across it
+        float uvDensity = mesh.GetUVDensity() > 0.0f ? mesh.GetUVDensity() * 2.0f * radius : 1.0f;
+        for (size_t slot = 0; slot < static_cast<size_t>(TextureSlot::Count); ++slot)
+            if (const Texture* texture = mesh.GetMaterial().GetTexture(static_cast<TextureSlot>(slot)))
+                Streamer->RequestDetail(texture->texture.ID, screenPixels, uvDensity);
+    }
 }
 
 unsigned int quadVAO = 0;
@@ -420,17 +968,17 @@ void RenderQuad()
         // setup plane VAO
         glGenVertexArrays(1, &quadVAO);
         glGenBuffers(1, &quadVBO);
-        glBindVertexArray(quadVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+        GLState::GetInstance().BindVertexArray(quadVAO);
+        GLState::GetInstance().BindBuffer(GL_ARRAY_BUFFER, quadVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
+        GpuMemory::GetInstance().TrackBuffer(quadVBO, sizeof(quadVertices), GpuMemoryCategory::Vertex, "screen quad");
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
         glEnableVertexAttribArray(1);
         glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
     }
-    glBindVertexArray(quadVAO);
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    glBindVertexArray(0);
+    GLState::GetInstance().BindVertexArray(quadVAO);
+    GLState::GetInstance().DrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 }
 
 std::vector<glm::vec3> GetFrustumCornersWorldSpace(const glm::mat4& viewProjMatrix)
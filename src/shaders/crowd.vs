@@ -0,0 +1,84 @@
+#version 330 core
+
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aTexCoords;
+layout(location = 3) in ivec4 aBoneIds;
+layout(location = 4) in vec4 aWeights;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+out vec4 FragPosLightSpace;
+out float JointWeight;
+
+uniform mat4 viewMatrix;
+uniform mat4 projectionMatrix;
+uniform mat4 lightSpaceMatrix;
+uniform bool shadowPass;
+
+// Baked clips, see AnimationTexture: one frame per row, three texels per joint
+const int MAX_CLIPS = 16;
+uniform sampler2D animationTexture;
+uniform vec3 animationClips[MAX_CLIPS]; // First row, number of frames, duration
+
+// Agents, see GpuCrowd: (position, yaw) then (clip, start time, rate, track)
+const int INSTANCES_PER_ROW = 512;
+const int MAX_TRACKS = 32;
+uniform sampler2D crowdInstances;
+uniform float trackTimes[MAX_TRACKS]; // Crowd time times the track's rate, wrapped to its clip
+
+const int MAX_BONE_INFLUENCE = 4;
+
+mat4 FetchJoint(int row, int joint)
+{
+    vec4 r0 = texelFetch(animationTexture, ivec2(joint * 3, row), 0);
+    vec4 r1 = texelFetch(animationTexture, ivec2(joint * 3 + 1, row), 0);
+    vec4 r2 = texelFetch(animationTexture, ivec2(joint * 3 + 2, row), 0);
+    return transpose(mat4(r0, r1, r2, vec4(0.0, 0.0, 0.0, 1.0)));
+}
+
+void main()
+{
+    ivec2 agentTexel = ivec2((gl_InstanceID % INSTANCES_PER_ROW) * 2, gl_InstanceID / INSTANCES_PER_ROW);
+    vec4 placement = texelFetch(crowdInstances, agentTexel, 0);
+    vec4 playback = texelFetch(crowdInstances, agentTexel + ivec2(1, 0), 0);
+
+    // Two neighbouring frames of the agent's clip, blended by the fraction in between
+    vec3 clip = animationClips[int(playback.x)];
+    float clipTime = mod(trackTimes[int(playback.w)] - playback.y * playback.z, clip.z);
+    float frame = clipTime / clip.z * (clip.y - 1.0);
+    int frame0 = min(int(frame), int(clip.y) - 1);
+    int frame1 = min(frame0 + 1, int(clip.y) - 1);
+    float blend = frame - float(frame0);
+    int row0 = int(clip.x) + frame0;
+    int row1 = int(clip.x) + frame1;
+
+    mat4 boneTransform = mat4(0.0);
+    for (int i = 0; i < MAX_BONE_INFLUENCE; ++i)
+    {
+        if (aBoneIds[i] == -1) continue;
+        mat4 joint = FetchJoint(row0, aBoneIds[i]) * (1.0 - blend) + FetchJoint(row1, aBoneIds[i]) * blend;
+        boneTransform += joint * aWeights[i];
+    }
+
+    float s = sin(placement.w);
+    float c = cos(placement.w);
+    mat4 modelMatrix = mat4(
+        vec4(c, 0.0, -s, 0.0),
+        vec4(0.0, 1.0, 0.0, 0.0),
+        vec4(s, 0.0, c, 0.0),
+        vec4(placement.xyz, 1.0));
+
+    vec4 worldPos = modelMatrix * boneTransform * vec4(aPos, 1.0);
+    FragPos = worldPos.xyz;
+    Normal = normalize(mat3(modelMatrix) * mat3(boneTransform) * aNormal);
+    TexCoords = aTexCoords;
+    FragPosLightSpace = lightSpaceMatrix * worldPos;
+    JointWeight = 0.0;
+
+    if (shadowPass)
+        gl_Position = lightSpaceMatrix * worldPos;
+    else
+        gl_Position = projectionMatrix * viewMatrix * worldPos;
+}
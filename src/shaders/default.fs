@@ -4,6 +4,7 @@ in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
 in vec4 FragPosLightSpace;
+in float JointWeight;
 
 layout(location = 0) out vec4 FragColor;
 
@@ -16,9 +17,23 @@ uniform float specularShininess;
 uniform float specularIntensity;
 
 uniform sampler2D texture_diffuse0;
+uniform sampler2DArray texture_diffuse_array0;
+uniform int diffuseLayer; // -1 samples texture_diffuse0 instead of the array
 uniform sampler2D texture_specular0;
 uniform sampler2D texture_normal0;
 uniform sampler2D depthMap;
+uniform int debugWeightJoint;
+
+// Clustered point and spot lights, see LightClusters
+const ivec3 CLUSTER_GRID = ivec3(16, 9, 24);
+uniform bool clusteredLights;
+uniform usamplerBuffer clusterGrid;         // Offset and count into clusterLightIndices per cluster
+uniform usamplerBuffer clusterLightIndices;
+uniform samplerBuffer clusterLights;        // Position and radius, color and outer cosine, direction and inner cosine
+uniform float clusterNear;
+uniform float clusterScale;                 // Depth slices per e-fold of view depth
+uniform vec2 clusterScreenSize;
+uniform mat4 viewMatrix;
 
 float CalcShadow(vec4 fragPosLightSpace, vec3 normal, vec3 lightDir)
 {
@@ -63,13 +78,65 @@ vec3 CalcBlinnPhong(vec3 viewDir, vec3 normal, vec3 lightDir, vec3 lightColor)
     return (ambientColor * ambientIntensity + (1.0 - shadow) * (diff * lightColor + spec * lightColor * specularIntensity));
 }
 
+// Lights of the fragment's cluster only; unshadowed
+vec3 CalcClusterLights(vec3 viewDir, vec3 normal)
+{
+    float depth = -(viewMatrix * vec4(FragPos, 1.0)).z;
+    ivec3 cluster = ivec3(ivec2(gl_FragCoord.xy / clusterScreenSize * vec2(CLUSTER_GRID.xy)),
+        int(log(max(depth / clusterNear, 1.0)) * clusterScale));
+    cluster = clamp(cluster, ivec3(0), CLUSTER_GRID - 1);
+    uvec2 range = texelFetch(clusterGrid, (cluster.z * CLUSTER_GRID.y + cluster.y) * CLUSTER_GRID.x + cluster.x).rg;
+
+    vec3 result = vec3(0.0);
+    for (uint i = 0u; i < range.y; ++i)
+    {
+        int light = int(texelFetch(clusterLightIndices, int(range.x + i)).r) * 3;
+        vec4 positionRadius = texelFetch(clusterLights, light);
+        vec4 colorOuterCos = texelFetch(clusterLights, light + 1);
+        vec4 directionInnerCos = texelFetch(clusterLights, light + 2);
+
+        vec3 toLight = positionRadius.xyz - FragPos;
+        float distance = length(toLight);
+        if (distance >= positionRadius.w)
+            continue;
+        vec3 L = toLight / distance;
+        // Inverse square, windowed to reach zero at the radius
+        float window = clamp(1.0 - pow(distance / positionRadius.w, 4.0), 0.0, 1.0);
+        float attenuation = window * window / (distance * distance + 1.0);
+        if (colorOuterCos.w > -1.0)
+            attenuation *= smoothstep(colorOuterCos.w, directionInnerCos.w, dot(-L, directionInnerCos.xyz));
+
+        float diff = max(dot(normal, L), 0.0);
+        vec3 halfwayDir = normalize(L + viewDir);
+        float spec = pow(max(dot(normal, halfwayDir), 0.0), specularShininess);
+        result += attenuation * (diff + spec * specularIntensity) * colorOuterCos.rgb;
+    }
+    return result;
+}
+
+// Blue (no influence) to green to red (full influence)
+vec3 HeatMap(float weight)
+{
+    return clamp(vec3(2.0 * weight - 1.0, 1.0 - abs(2.0 * weight - 1.0), 1.0 - 2.0 * weight), 0.0, 1.0);
+}
+
 void main()
 {
+    if (debugWeightJoint >= 0)
+    {
+        FragColor = vec4(HeatMap(JointWeight), 1.0);
+        return;
+    }
+
     vec3 norm = normalize(Normal);
     vec3 viewDir = normalize(cameraPos - FragPos);
-    vec3 Albedo = texture(texture_diffuse0, TexCoords).rgb;
+    vec3 Albedo = diffuseLayer >= 0
+        ? texture(texture_diffuse_array0, vec3(TexCoords, diffuseLayer)).rgb
+        : texture(texture_diffuse0, TexCoords).rgb;
 
     vec3 result = CalcBlinnPhong(viewDir, norm, lightDir, lightColor) * Albedo;
+    if (clusteredLights)
+        result += CalcClusterLights(viewDir, norm) * Albedo;
 
     FragColor = vec4(result, 1.0);
 }
\ No newline at end of file
@@ -5,11 +5,13 @@ layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec2 aTexCoords;
 layout(location = 3) in ivec4 aBoneIds;
 layout(location = 4) in vec4 aWeights;
+layout(location = 5) in mat4 aInstanceMatrix; // Model matrix per instance, see InstancedModel
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
 out vec4 FragPosLightSpace;
+out float JointWeight;
 
 uniform mat4 modelMatrix;
 uniform mat4 viewMatrix;
@@ -17,16 +19,23 @@ uniform mat4 projectionMatrix;
 uniform mat3 normalMatrix;
 uniform mat4 lightSpaceMatrix;
 uniform bool shadowPass;
+uniform bool instanced; // Takes modelMatrix and normalMatrix from aInstanceMatrix, which must scale uniformly
 
 uniform bool animated;
 const int MAX_BONES = 100;
 const int MAX_BONE_INFLUENCE = 4;
 uniform mat4 finalBonesMatrices[MAX_BONES];
+uniform int debugWeightJoint; // -1 disables the weight heat-map
 
 void main()
 {
+    mat4 model = instanced ? aInstanceMatrix : modelMatrix;
+    // Instances are only scaled uniformly, so their rotation part transforms normals up to length, which
+    // the fragment shaders normalize
+    mat3 normalTransform = instanced ? mat3(aInstanceMatrix) : normalMatrix;
     vec4 totalPosition = vec4(0.0);
     vec3 localNormal = vec3(0.0);
+    JointWeight = 0.0;
 
     if (animated)
     {
@@ -38,6 +47,8 @@ void main()
             if (aBoneIds[i] >= MAX_BONES) break;
 
             boneTransform += finalBonesMatrices[aBoneIds[i]] * aWeights[i];
+            if (aBoneIds[i] == debugWeightJoint)
+                JointWeight += aWeights[i];
         }
 
         // Apply it to position
@@ -47,15 +58,15 @@ void main()
         localNormal = mat3(boneTransform) * aNormal;
 
         // Final World Space Normal
-        Normal = normalize(normalMatrix * localNormal);
+        Normal = normalize(normalTransform * localNormal);
     }
     else
     {
         totalPosition = vec4(aPos, 1.0f);
-        Normal = normalize(normalMatrix * aNormal);
+        Normal = normalize(normalTransform * aNormal);
     }
 
-    vec4 worldPos = modelMatrix * totalPosition;
+    vec4 worldPos = model * totalPosition;
     FragPos = worldPos.xyz;
     TexCoords = aTexCoords;
     FragPosLightSpace = lightSpaceMatrix * vec4(FragPos, 1.0);
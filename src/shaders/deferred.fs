@@ -0,0 +1,114 @@
+#version 330 core
+
+in vec2 TexCoords;
+
+layout(location = 0) out vec4 FragColor;
+
+uniform mat4 inverseViewProjection;
+uniform mat4 viewMatrix;
+uniform mat4 lightSpaceMatrix;
+uniform vec3 cameraPos;
+uniform vec3 lightDir;
+uniform vec3 lightColor;
+uniform vec3 ambientColor;
+uniform float ambientIntensity;
+uniform float specularIntensity;
+
+uniform sampler2D gAlbedoRoughness;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+uniform sampler2D depthMap;
+
+// Clustered point and spot lights, see LightClusters and default.fs
+const ivec3 CLUSTER_GRID = ivec3(16, 9, 24);
+uniform bool clusteredLights;
+uniform usamplerBuffer clusterGrid;
+uniform usamplerBuffer clusterLightIndices;
+uniform samplerBuffer clusterLights;
+uniform float clusterNear;
+uniform float clusterScale;
+uniform vec2 clusterScreenSize;
+
+vec3 DecodeOctahedron(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+
+// Same 3x3 PCF as default.fs
+float CalcShadow(vec3 fragPos, vec3 normal, vec3 lightDir)
+{
+    vec4 fragPosLightSpace = lightSpaceMatrix * vec4(fragPos, 1.0);
+    vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w * 0.5 + 0.5;
+    if (projCoords.z > 1.0)
+        return 0.0;
+    float bias = mix(0.0005, 0.0, dot(normal, lightDir));
+    float shadow = 0.0;
+    vec2 texelSize = 1.0 / textureSize(depthMap, 0);
+    for (int x = -1; x <= 1; ++x)
+        for (int y = -1; y <= 1; ++y)
+            shadow += projCoords.z - bias > texture(depthMap, projCoords.xy + vec2(x, y) * texelSize).r ? 1.0 : 0.0;
+    return shadow / 9.0;
+}
+
+vec3 CalcClusterLights(vec3 fragPos, vec3 viewDir, vec3 normal, float shininess)
+{
+    float depth = -(viewMatrix * vec4(fragPos, 1.0)).z;
+    ivec3 cluster = ivec3(ivec2(gl_FragCoord.xy / clusterScreenSize * vec2(CLUSTER_GRID.xy)),
+        int(log(max(depth / clusterNear, 1.0)) * clusterScale));
+    cluster = clamp(cluster, ivec3(0), CLUSTER_GRID - 1);
+    uvec2 range = texelFetch(clusterGrid, (cluster.z * CLUSTER_GRID.y + cluster.y) * CLUSTER_GRID.x + cluster.x).rg;
+
+    vec3 result = vec3(0.0);
+    for (uint i = 0u; i < range.y; ++i)
+    {
+        int light = int(texelFetch(clusterLightIndices, int(range.x + i)).r) * 3;
+        vec4 positionRadius = texelFetch(clusterLights, light);
+        vec4 colorOuterCos = texelFetch(clusterLights, light + 1);
+        vec4 directionInnerCos = texelFetch(clusterLights, light + 2);
+
+        vec3 toLight = positionRadius.xyz - fragPos;
+        float distance = length(toLight);
+        if (distance >= positionRadius.w)
+            continue;
+        vec3 L = toLight / distance;
+        float window = clamp(1.0 - pow(distance / positionRadius.w, 4.0), 0.0, 1.0);
+        float attenuation = window * window / (distance * distance + 1.0);
+        if (colorOuterCos.w > -1.0)
+            attenuation *= smoothstep(colorOuterCos.w, directionInnerCos.w, dot(-L, directionInnerCos.xyz));
+
+        float diff = max(dot(normal, L), 0.0);
+        float spec = pow(max(dot(normal, normalize(L + viewDir)), 0.0), shininess);
+        result += attenuation * (diff + spec * specularIntensity) * colorOuterCos.rgb;
+    }
+    return result;
+}
+
+void main()
+{
+    // Same pixel as in the G-buffer, which may be larger than the viewport under dynamic resolution
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, pixel, 0).r;
+    if (depth >= 1.0)
+        discard; // Nothing drawn here, keep the clear color
+
+    vec4 world = inverseViewProjection * vec4(vec3(TexCoords, depth) * 2.0 - 1.0, 1.0);
+    vec3 fragPos = world.xyz / world.w;
+    vec4 albedoRoughness = texelFetch(gAlbedoRoughness, pixel, 0);
+    vec3 albedo = albedoRoughness.rgb;
+    float roughness = max(albedoRoughness.a, 0.05);
+    float shininess = 2.0 / pow(roughness, 4.0) - 2.0;
+    vec3 normal = DecodeOctahedron(texelFetch(gNormal, pixel, 0).rg);
+    vec3 viewDir = normalize(cameraPos - fragPos);
+
+    float diff = max(dot(normal, lightDir), 0.0);
+    float spec = pow(max(dot(viewDir, normalize(lightDir + viewDir)), 0.0), shininess);
+    float shadow = CalcShadow(fragPos, normal, lightDir);
+    vec3 result = (ambientColor * ambientIntensity + (1.0 - shadow) * (diff * lightColor + spec * lightColor * specularIntensity)) * albedo;
+    if (clusteredLights)
+        result += CalcClusterLights(fragPos, viewDir, normal, shininess) * albedo;
+
+    FragColor = vec4(result, 1.0);
+}
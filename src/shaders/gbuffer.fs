@@ -0,0 +1,36 @@
+#version 330 core
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoords;
+in vec4 FragPosLightSpace;
+in float JointWeight;
+
+layout(location = 0) out vec4 AlbedoRoughness;
+layout(location = 1) out vec2 EncodedNormal;
+
+uniform float specularShininess;
+
+uniform sampler2D texture_diffuse0;
+uniform sampler2DArray texture_diffuse_array0;
+uniform int diffuseLayer; // -1 samples texture_diffuse0 instead of the array
+
+// Unit vector folded onto the octahedron, then the octahedron unfolded onto [-1, 1]^2
+vec2 EncodeOctahedron(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 folded = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return n.z >= 0.0 ? n.xy : folded;
+}
+
+void main()
+{
+    vec3 albedo = diffuseLayer >= 0
+        ? texture(texture_diffuse_array0, vec3(TexCoords, diffuseLayer)).rgb
+        : texture(texture_diffuse0, TexCoords).rgb;
+    // Blinn-Phong exponent as roughness, inverted again in deferred.fs
+    float roughness = pow(2.0 / (specularShininess + 2.0), 0.25);
+
+    AlbedoRoughness = vec4(albedo, roughness);
+    EncodedNormal = EncodeOctahedron(normalize(Normal));
+}
@@ -1,11 +1,15 @@
 #version 330 core
 
 layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec4 aColor;
+
+out vec4 Color;
 
 uniform mat4 viewMatrix;
 uniform mat4 projectionMatrix;
 
 void main()
 {
+    Color = aColor;
     gl_Position = projectionMatrix * viewMatrix * vec4(aPos, 1.0);
-}
\ No newline at end of file
+}
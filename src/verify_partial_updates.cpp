@@ -0,0 +1,100 @@
+// File: verify_partial_updates.cpp
+// Samples every clip of an asset through two ozz models, one recomputing only the subtrees under changed
+// joints and one recomputing all of them, and checks their palettes match bit for bit. Each time is
+// sampled twice, so the sequence covers unchanged poses as well as clip switches.
+// Usage: verify-partial-updates [asset] [frames]
+#include "animated_model.hpp"
+#include "model_loader.hpp"
+
+#include <glad/gl.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <string>
+
+static bool verify(const std::string& path, unsigned int frames)
+{
+    AnimatedModel partial, full;
+    ModelLoader& loader = ModelLoader::GetInstance();
+    if (!loader.LoadFromFile(path, partial) || !loader.LoadFromFile(path, full) || !partial.HasAnimations())
+    {
+        std::cerr << "ERROR::VERIFYPARTIALUPDATES: No animations to verify in \"" << path << "\"" << std::endl;
+        return false;
+    }
+    full.SetPartialUpdates(false);
+
+    const float deltaTime = 1.0f / 60.0f;
+    const size_t paletteBytes = partial.GetPalette().GetSize() * sizeof(glm::mat4);
+    size_t samples = 0, mismatches = 0, updatedJoints = 0;
+    for (unsigned int animation = 0; animation < partial.GetNumAnimations(); ++animation)
+    {
+        partial.SetCurrentAnimation(animation);
+        full.SetCurrentAnimation(animation);
+        for (unsigned int i = 0; i < frames; ++i)
+        {
+            partial.Sample((i / 2) * deltaTime);
+            full.Sample((i / 2) * deltaTime);
+            ++samples;
+            updatedJoints += partial.GetUpdatedJoints();
+            if (memcmp(partial.GetPalette().GetMatrices().data(), full.GetPalette().GetMatrices().data(), paletteBytes) != 0)
+                ++mismatches;
+        }
+    }
+
+    std::cout << "Partial LocalToModel \"" << path << "\": " << samples - mismatches << " of " << samples
+              << " palettes identical to full updates, " << updatedJoints * 100.0 / (static_cast<double>(samples) * partial.GetNumJoints())
+              << "% of joints recomputed" << std::endl;
+    if (mismatches > 0)
+        std::cerr << "ERROR::VERIFYPARTIALUPDATES: Partial LocalToModel updates differ from full updates" << std::endl;
+    return mismatches == 0;
+}
+
+int main(int argc, char** argv)
+{
+    const std::string path = argc > 1 ? argv[1] : "assets/vanguard.glb";
+    const unsigned int frames = argc > 2 ? static_cast<unsigned int>(std::stoul(argv[2])) : 500;
+
+    // glfw: a hidden window only provides the context the model's meshes and textures are created in
+    // ----------------------------------------------------------------------------------------------
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+    GLFWwindow* window = glfwCreateWindow(64, 64, "verify-partial-updates", nullptr, nullptr);
+    if (window == nullptr)
+    {
+        std::cerr << "ERROR::GLFW: Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+
+    if (gladLoadGL(glfwGetProcAddress) == 0)
+    {
+        std::cerr << "ERROR::GLAD: Failed to initialize GLAD" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+    int result = 0;
+    try
+    {
+        result = verify(path, frames) ? 0 : 1;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "ERROR::VERIFYPARTIALUPDATES: " << e.what() << std::endl;
+        result = 1;
+    }
+
+    glfwTerminate();
+    return result;
+}